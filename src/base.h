@@ -65,6 +65,7 @@ class smoother;
 #define DIFFICULTY_SETTINGS 3
 
 Uint32 random(Uint32 x);
+Uint32 random_from(Uint32& seed, Uint32 x);
 
 #define VIDEO_ADDRESS 0xA000
 #define VIDEO_LINEAR ( (VIDEO_ADDRESS) << 4)
@@ -170,6 +171,7 @@ char* read_one_line(SDL_RWops *infile, short length);
 
 // Other screen-type things
 #define NUM_SPECIALS 6
+#define MAX_VIEWS 5 // viewscreens a screen can hold
 
 // Animation Types : Livings
 #define ANI_WALK 0
@@ -339,9 +341,10 @@ extern "C" void play_sound(short which);
 #endif
 
 class PixieData;
+class PixieArena;
 
 //most of these are graphlib and are being ported to video
-void load_map_data(PixieData* whereto);
+void load_map_data(PixieData* whereto, PixieArena* arena = NULL);
 char* get_cfg_item(char *section, char *item);
 
 // Functions in game.cpp
@@ -374,7 +377,7 @@ short load_saved_game(const char *filename, screen  *myscreen);
 
 #include "pixie_data.h"
 
-PixieData read_pixie_file(const char  * filename);
+PixieData read_pixie_file(const char  * filename, PixieArena* arena = NULL);
 
 // Some stuff for palette
 typedef struct
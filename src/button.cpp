@@ -534,6 +534,16 @@ void toggle_rendering_engine()
     if(engine == "sai")
         engine = "eagle";
     else if(engine == "eagle")
+        engine = "scale2x";
+    else if(engine == "scale2x")
+        engine = "scale3x";
+    else if(engine == "scale3x")
+        engine = "nearest2x";
+    else if(engine == "nearest2x")
+        engine = "nearest3x";
+    else if(engine == "nearest3x")
+        engine = "nearest4x";
+    else if(engine == "nearest4x")
         engine = "normal";
     else
         engine = "sai";
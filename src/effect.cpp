@@ -46,7 +46,8 @@ short effect::act()
 	Sint32 distance, generic;
 	walker *newob;
 	short numfoes;
-	std::list<walker*> foelist;
+	std::list<walker*> weaps;
+	std::vector<walker*> foelist;
 
 	// Make sure everyone we're pointing to is valid
 	if (foe && foe->dead)
@@ -144,10 +145,10 @@ short effect::act()
 			}
 			center_on(owner);
 			setworldxy(worldx+xd, worldy+yd);
-			foelist = myscreen->find_foe_weapons_in_range(
+			weaps = myscreen->find_foe_weapons_in_range(
 			              myscreen->level_data.oblist, sizex, &temp, this);
             
-			for(auto e = foelist.begin(); e != foelist.end(); e++)  // first weapons
+			for(auto e = weaps.begin(); e != weaps.end(); e++)  // first weapons
 			{
 			    walker* w = *e;
 				stats->hitpoints -= w->damage;
@@ -155,8 +156,7 @@ short effect::act()
 				w->death();
 			}
 			
-			foelist = myscreen->find_foes_in_range(
-			              myscreen->level_data.oblist, sizex, &temp, this);
+			temp = myscreen->find_foes_in_range(this, sizex, foelist);
             
 			for(auto e = foelist.begin(); e != foelist.end(); e++)  // second enemies
 			{
@@ -259,10 +259,10 @@ short effect::act()
 			yd /= 48;
 			center_on(owner);
 			setworldxy(worldx+xd, worldy+yd);
-			foelist = myscreen->find_foe_weapons_in_range(
+			weaps = myscreen->find_foe_weapons_in_range(
 			              myscreen->level_data.oblist, sizex*2, &temp, this);
 			              
-			for(auto e = foelist.begin(); e != foelist.end(); e++)  // first weapons
+			for(auto e = weaps.begin(); e != weaps.end(); e++)  // first weapons
 			{
 			    walker* w = *e;
 				stats->hitpoints -= w->damage;
@@ -270,8 +270,7 @@ short effect::act()
 				w->death();
 			}
 			
-			foelist = myscreen->find_foes_in_range(
-			              myscreen->level_data.oblist, sizex, &temp, this);
+			temp = myscreen->find_foes_in_range(this, sizex, foelist);
             
 			for(auto e = foelist.begin(); e != foelist.end(); e++) // second enemies
 			{
@@ -329,7 +328,7 @@ short effect::act()
 				newob = myscreen->level_data.add_ob(ORDER_WEAPON, FAMILY_KNIFE);
 				newob->damage = damage;
 				newob->owner = owner;
-				newob->team_num = team_num;
+				newob->set_team(team_num);
 				newob->death_called = 1; // to ensure no spawning of more ..
 				newob->setworldxy(worldx, worldy);
 				if (!myscreen->query_object_passable(xpos+xd, ypos+yd, newob))
@@ -365,8 +364,7 @@ short effect::act()
 			if (invisibility_left > 0)
 				invisibility_left--;
 			// Hit any nearby foes (not friends, for now)
-			foelist = myscreen->find_foes_in_range(
-			              myscreen->level_data.oblist, sizex, &temp, this);
+			temp = myscreen->find_foes_in_range(this, sizex, foelist);
             
 			for(auto e = foelist.begin(); e != foelist.end(); e++) //
 			{
@@ -414,7 +412,7 @@ short effect::act()
 					return 1; // failsafe
 				}
 				newob->owner = owner;
-				newob->team_num = team_num;
+				newob->set_team(team_num);
 				newob->stats->level = stats->level;
 				newob->damage = damage;
 				newob->ani_type = ANI_EXPLODE;
@@ -426,11 +424,9 @@ short effect::act()
 				// First, are our offspring powerful enough at 1/2 our power?
 				generic = (damage)/2;
 				if (owner->myguy)
-					foelist = myscreen->find_foes_in_range(myscreen->level_data.oblist,
-					                                      240+(owner->myguy->intelligence/2), &temp, this);
+					temp = myscreen->find_foes_in_range(this, 240+(owner->myguy->intelligence/2), foelist, true);
 				else
-					foelist = myscreen->find_foes_in_range(myscreen->level_data.oblist,
-					                                      240+stats->level*5, &temp, this);
+					temp = myscreen->find_foes_in_range(this, 240+stats->level*5, foelist, true);
 				if (temp && generic>20) // more foes to find ..
 				{
 					numfoes = random(owner->stats->level)+1;
@@ -448,7 +444,7 @@ short effect::act()
 							newob->stats->level = stats->level;
 							newob->stats->set_bit_flags(BIT_MAGICAL, 1);
 							newob->damage = generic;
-							newob->team_num = team_num;
+							newob->set_team(team_num);
 							newob->center_on(this);
 						} // end of wasn't current guy case
 					} // end of loop for nearby foes we found
@@ -526,7 +522,7 @@ short effect::act()
 			newob->ani_type = ANI_WALK;
 			newob->setworldxy(worldx, worldy);
 			newob->stats->level = stats->level;
-			newob->team_num = team_num;
+			newob->set_team(team_num);
 			newob->ignore = 1;
 			newob->curdir = curdir;
 			// set correct frame
@@ -587,7 +583,7 @@ short effect::death()
 	// Note that the 'dead' variable should ALREADY be set by the
 	// time this function is called, so that we can easily reverse
 	// the decision :)
-	std::list<walker*> foelist;
+	std::vector<walker*> foelist;
 	short howmany = 0;
 	walker  *newob;
 	Sint32 xdelta,ydelta;
@@ -602,8 +598,7 @@ short effect::death()
 		case FAMILY_GHOST_SCARE: // the ghost's scare
 			if (!owner || owner->dead)
 				return 0;
-			foelist = myscreen->find_foes_in_range(myscreen->level_data.oblist, 50+(10*owner->stats->level),
-			                                        &howmany, owner);
+			howmany = myscreen->find_foes_in_range(owner, 50+(10*owner->stats->level), foelist);
 			if (howmany < 1)
 				return 0;
             
@@ -654,8 +649,13 @@ short effect::death()
 			{
 				generic = 16;
 			}
-			foelist = myscreen->find_in_range(myscreen->level_data.oblist, 15+generic,
-			                                 &howmany, this);
+			// Whatever stands around, not weapons in flight; treasure and
+			// effects are skipped below anyway
+			howmany = myscreen->find_in_range(this, 15+generic,
+			                                  RANGE_ALL_ORDERS & ~(RANGE_ORDER(ORDER_WEAPON) |
+			                                                       RANGE_ORDER(ORDER_TREASURE) |
+			                                                       RANGE_ORDER(ORDER_FX)),
+			                                  foelist);
             
 			// Damage our tile location ..
 			myscreen->damage_tile( (short) (xpos+(sizex/2)), (short) (ypos+(sizey/2)) );
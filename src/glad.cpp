@@ -45,8 +45,6 @@ void popup_dialog(const char* title, const char* message);
 void picker_main(Sint32 argc, char **argv);
 void intro_main(Sint32 argc, char **argv);
 
-short remaining_foes(screen *myscreen, walker* myguy);
-short remaining_team(screen *myscreen, char myteam);
 short score_panel(screen *myscreen);
 short score_panel(screen *myscreen, short do_it);
 short new_score_panel(screen *myscreen, short do_it);
@@ -253,42 +251,6 @@ void glad_main(Sint32 playermode)
 	//  return 1;
 }
 
-// remaining_foes returns # of livings left not on control's team
-short remaining_foes(screen *myscreen, walker* myguy)
-{
-	short myfoes = 0;
-
-	const std::list<walker*>& foelist = myscreen->level_data.oblist;
-	for(auto e = foelist.begin(); e != foelist.end(); e++)
-	{
-	    walker* w = *e;
-		if (w && !w->dead &&
-		        (w->query_order() == ORDER_LIVING) &&
-		        !myguy->is_friendly(w) )
-			myfoes++;
-	}
-
-	return myfoes;
-}
-
-// remaining_team returns # of livings left on team myteam
-short remaining_team(screen *myscreen, char myteam)
-{
-	short myfoes = 0;
-
-	const std::list<walker*>& foelist = myscreen->level_data.oblist;
-	for(auto e = foelist.begin(); e != foelist.end(); e++)
-	{
-	    walker* w = *e;
-		if (w && !w->dead &&
-		        (w->query_order() == ORDER_LIVING) &&
-		        (myteam == w->team_num) )
-			myfoes++;
-	}
-
-	return myfoes;
-}
-
 short score_panel(screen *myscreen)
 {
 	return score_panel(myscreen, 0);
@@ -597,10 +559,10 @@ short new_score_panel(screen *myscreen, short do_it)
 			else
 				text_color = YELLOW;
 
-			// Get current number of foes
-			tempfoes = remaining_foes(myscreen, control);
+			// Get current number of foes, as counted in screen::act
+			tempfoes = myscreen->level_data.count_foes(control);
 			// Get current number of team-members
-			tempallies = remaining_team(myscreen, control->team_num);
+			tempallies = myscreen->level_data.count_team(control->team_num);
 
 			// Draw the pretty gems
 			//draw_radar_gems(myscreen);
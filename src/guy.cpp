@@ -590,7 +590,7 @@ walker* guy::create_walker(screen* myscreen)
     update_derived_stats(temp_walker);
 
     // Set our team number ..
-    temp_walker->team_num = temp_guy->teamnum;
+    temp_walker->set_team(temp_guy->teamnum);
     temp_walker->real_team_num = 255;
     
     return temp_walker;
@@ -606,7 +606,7 @@ walker* guy::create_and_add_walker(screen* myscreen)
     update_derived_stats(temp_walker);
 
     // Set our team number ..
-    temp_walker->team_num = temp_guy->teamnum;
+    temp_walker->set_team(temp_guy->teamnum);
     temp_walker->real_team_num = 255;
     
     return temp_walker;
@@ -360,7 +360,9 @@ void handle_key_event(const SDL_Event& event)
             input_continue = true;
         key_press_event = 1;
         
-        if(event.key.keysym.sym == SDLK_F10)
+        if(event.key.keysym.sym == SDLK_F10 && event.key.keysym.mod & KMOD_SHIFT)
+            myscreen->toggle_recording();
+        else if(event.key.keysym.sym == SDLK_F10)
             myscreen->save_screenshot();
         else if(event.key.keysym.sym == SDLK_F12 && event.key.keysym.mod & KMOD_CTRL)
         {
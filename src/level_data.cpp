@@ -25,6 +25,7 @@
 #include "smooth.h"
 #include "screen.h"
 #include "view.h"
+#include "radar.h"
 #include <algorithm>
 
 
@@ -290,8 +291,10 @@ std::string CampaignData::getDescriptionLine(int i)
 
 LevelData::LevelData(int id)
     : id(id), title("New Level"), type(0), par_value(1), time_bonus_limit(4000), pixmaxx(0), pixmaxy(0)
-    , myloader(NULL), numobs(0), topx(0), topy(0)
+    , myloader(NULL), numobs(0), next_draw_order(0), foes_indexed(false), topx(0), topy(0)
+    , background(NULL), background_w(0), background_h(0), radar_map(NULL)
 {
+    memset(living_count, 0, sizeof(living_count));
     for (int i = 0; i < PIX_MAX; i++)
     {
         back[i] = NULL;
@@ -302,29 +305,11 @@ LevelData::LevelData(int id)
     myloader = new loader;
 	
     // Load map data from a pixie format
-    load_map_data(pixdata);
+    load_map_data(pixdata, &tile_arena);
 
     // Initialize a pixie for each background piece
     for(int i = 0; i < PIX_MAX; i++)
         back[i] = new pixieN(pixdata[i], 0);
-
-    //buffers: after we set all the tiles to use acceleration, we go
-    //through the tiles that have pal cycling to turn of the accel.
-    back[PIX_WATER1]->set_accel(0);
-    back[PIX_WATER2]->set_accel(0);
-    back[PIX_WATER3]->set_accel(0);
-    back[PIX_WATERGRASS_LL]->set_accel(0);
-    back[PIX_WATERGRASS_LR]->set_accel(0);
-    back[PIX_WATERGRASS_UL]->set_accel(0);
-    back[PIX_WATERGRASS_UR]->set_accel(0);
-    back[PIX_WATERGRASS_U]->set_accel(0);
-    back[PIX_WATERGRASS_D]->set_accel(0);
-    back[PIX_WATERGRASS_L]->set_accel(0);
-    back[PIX_WATERGRASS_R]->set_accel(0);
-    back[PIX_GRASSWATER_LL]->set_accel(0);
-    back[PIX_GRASSWATER_LR]->set_accel(0);
-    back[PIX_GRASSWATER_UL]->set_accel(0);
-    back[PIX_GRASSWATER_UR]->set_accel(0);
 }
 
 LevelData::~LevelData()
@@ -346,6 +331,7 @@ LevelData::~LevelData()
             back[i] = NULL;
         }
     }
+    tile_arena.free();
 }
 
 void LevelData::clear()
@@ -379,7 +365,12 @@ walker* LevelData::add_ob(char order, char family, bool atstart)
     if (order == ORDER_LIVING)
         numobs++;
     
+    w->draw_layer = 1;
+    w->draw_order = next_draw_order++;
     oblist.push_back(w);
+    late_foe(w);
+    w->mylevel = this;
+    count_living(w);
     return w;
 }
 
@@ -391,6 +382,8 @@ walker* LevelData::add_fx_ob(char order, char family)
 	//numobs++;
 	//w->ignore = 1;
 	
+    w->draw_layer = 0;
+    w->draw_order = next_draw_order++;
 	fxlist.push_back(w);
 	return w;
 }
@@ -400,12 +393,28 @@ walker* LevelData::add_weap_ob(char order, char family)
 	walker* w = myloader->create_walker(order, family, myscreen);
     w->myobmap = this->myobmap;
     
+    w->draw_layer = 2;
+    w->draw_order = next_draw_order++;
     weaplist.push_back(w);
 	return w;
 }
 
+void LevelData::prepare_frame(short views)
+{
+    for(auto e = fxlist.begin(); e != fxlist.end(); e++)
+        if(*e)
+            (*e)->prepare_frame(views);
+    for(auto e = oblist.begin(); e != oblist.end(); e++)
+        if(*e)
+            (*e)->prepare_frame(views);
+    for(auto e = weaplist.begin(); e != weaplist.end(); e++)
+        if(*e)
+            (*e)->prepare_frame(views);
+}
+
 short LevelData::remove_ob(walker  *ob)
 {
+    foes_indexed = false;
 	if (ob && ob->query_order() == ORDER_LIVING)
 		numobs--;
     
@@ -427,17 +436,329 @@ short LevelData::remove_ob(walker  *ob)
     if(e != oblist.end())
     {
         oblist.erase(e);
+        ob->mylevel = NULL;
+        count_living(ob);
         return 1;
     }
 
 	return 0;
 }
 
+// Moves w into or out of living_count, by how it stands now.  Kept up
+// as things happen (add_ob, remove_ob, walker::death, walker::set_team
+// ..), so the HUD and the level end check never walk the list.
+void LevelData::count_living(walker* w)
+{
+    if(w->counted)
+    {
+        living_count[w->counted_team][(int)w->counted_hired]--;
+        w->counted = 0;
+    }
+    
+    if(w->mylevel != this || w->dead || w->query_order() != ORDER_LIVING || w->team_num > MAX_TEAM)
+        return;
+    
+    w->counted = 1;
+    w->counted_team = w->team_num;
+    w->counted_hired = (w->myguy != NULL);
+    living_count[w->counted_team][(int)w->counted_hired]++;
+}
+
+// Livings left on team
+short LevelData::count_team(unsigned char team)
+{
+    if(team > MAX_TEAM)
+        return 0;
+    return living_count[team][0] + living_count[team][1];
+}
+
+// Same chain walk as walker::is_friendly
+static walker* head_of_chain(walker* w)
+{
+    while(w->owner && (w->owner->dead == 0) && (w->owner != w))
+        w = w->owner;
+    return w;
+}
+
+// Whether walker::is_friendly would call these two chain heads foes
+static bool heads_are_foes(unsigned char us, bool us_hired, unsigned char them, bool them_hired)
+{
+    if(myscreen->save_data.allied_mode == 0 || (!us_hired && !them_hired))
+        return (us != them);
+    // allied: hired guys are friends with each other, and with team 0
+    if(us_hired && them_hired)
+        return false;
+    return !((!them_hired && them == 0) || (!us_hired && us == 0));
+}
+
+// Livings left that aren't friendly to myguy, as in walker::is_friendly.
+// Each is taken as the head of its own owner chain.
+short LevelData::count_foes(walker* myguy)
+{
+    walker* head = head_of_chain(myguy);
+    bool hired = (head->myguy != NULL);
+    short foes = 0;
+    
+    for(int team = 0; team <= MAX_TEAM; team++)
+    {
+        for(int target_hired = 0; target_hired < 2; target_hired++)
+        {
+            // is_friendly calls everyone a foe of the dead
+            if(myguy->dead || heads_are_foes(head->team_num, hired, team, target_hired))
+                foes += living_count[team][target_hired];
+        }
+    }
+    
+    return foes;
+}
+
+// Livings left that aren't friendly to team, as in walker::is_friendly_to_team.
+// While enemies are frozen only team 0 acts, so only it can hold the level.
+short LevelData::count_foes_of_team(unsigned char team, bool frozen)
+{
+    short foes = 0;
+    
+    for(int t = 0; t <= MAX_TEAM; t++)
+    {
+        if(frozen && t != 0)
+            continue;
+        // not hired: their team must match
+        if(t != team)
+            foes += living_count[t][0];
+        // hired: in allied mode they're friends with team 0
+        if(myscreen->save_data.allied_mode == 0 ? (t != team) : (team != 0))
+            foes += living_count[t][1];
+    }
+    
+    return foes;
+}
+
+static bool spot_x_less(const FoeSpot& a, const FoeSpot& b)
+{
+    return a.x < b.x;
+}
+
+static bool spot_y_less(const FoeSpot& a, const FoeSpot& b)
+{
+    return a.y < b.y;
+}
+
+// Lays spots[lo, hi) out as a k-d tree: the middle one splits the rest,
+// by x at even depths and by y at odd ones
+static void build_foe_tree(std::vector<FoeSpot>& spots, int lo, int hi, int depth)
+{
+    if(hi - lo < 2)
+        return;
+    
+    int mid = (lo + hi)/2;
+    std::nth_element(spots.begin() + lo, spots.begin() + mid, spots.begin() + hi,
+                     (depth & 1) ? spot_y_less : spot_x_less);
+    build_foe_tree(spots, lo, mid, depth + 1);
+    build_foe_tree(spots, mid + 1, hi, depth + 1);
+}
+
+// Still a foe we can see?  Owners can die and teams change after indexing
+static bool foe_will_do(walker* ob, walker* w)
+{
+    return (!w->dead && ob->is_friendly(w) == 0 && !random(w->invisibility_left/20));
+}
+
+static void search_foe_tree(std::vector<FoeSpot>& spots, int lo, int hi, int depth,
+                            walker* ob, walker*& best, Sint32& best_distance)
+{
+    if(lo >= hi)
+        return;
+    
+    int mid = (lo + hi)/2;
+    FoeSpot& spot = spots[mid];
+    Sint32 distance = abs(spot.x - ob->xpos) + abs(spot.y - ob->ypos);  // as walker::distance_to_ob
+    if(distance < best_distance && foe_will_do(ob, spot.ob))
+    {
+        best = spot.ob;
+        best_distance = distance;
+    }
+    
+    // Our side of the split first, then the other only if it could be nearer
+    Sint32 split = (depth & 1) ? (ob->ypos - spot.y) : (ob->xpos - spot.x);
+    if(split < 0)
+    {
+        search_foe_tree(spots, lo, mid, depth + 1, ob, best, best_distance);
+        if(-split < best_distance)
+            search_foe_tree(spots, mid + 1, hi, depth + 1, ob, best, best_distance);
+    }
+    else
+    {
+        search_foe_tree(spots, mid + 1, hi, depth + 1, ob, best, best_distance);
+        if(split < best_distance)
+            search_foe_tree(spots, lo, mid, depth + 1, ob, best, best_distance);
+    }
+}
+
+// Sorts who could be anyone's foe by the head of their owner chain, as
+// is_friendly does, so find_nearest_foe() can skip whole teams.  Taken
+// from where everyone stands now; screen::act calls this as each tick
+// starts.
+void LevelData::index_foes()
+{
+    for(int t = 0; t <= MAX_TEAM; t++)
+    {
+        foe_spots[t][0].clear();
+        foe_spots[t][1].clear();
+    }
+    odd_foe_spots.clear();
+    
+    for(auto e = oblist.begin(); e != oblist.end(); e++)
+    {
+        walker* w = *e;
+        if(w == NULL || w->dead ||
+           (w->query_order() != ORDER_LIVING && w->query_order() != ORDER_GENERATOR))
+            continue;
+        
+        walker* head = head_of_chain(w);
+        FoeSpot spot = {w->xpos, w->ypos, w};
+        if(head->team_num <= MAX_TEAM)
+            foe_spots[head->team_num][head->myguy != NULL].push_back(spot);
+        else
+            odd_foe_spots.push_back(spot);
+    }
+    
+    for(int t = 0; t <= MAX_TEAM; t++)
+    {
+        build_foe_tree(foe_spots[t][0], 0, foe_spots[t][0].size(), 0);
+        build_foe_tree(foe_spots[t][1], 0, foe_spots[t][1].size(), 0);
+    }
+    
+    foes_indexed = true;
+}
+
+// w joined or changed sides after the index was taken, so its tree won't
+// have it where find_nearest_foe() looks: keep it with the odd ones until
+// the next index
+void LevelData::late_foe(walker* w)
+{
+    if(!foes_indexed)
+        return;
+    FoeSpot spot = {0, 0, w};
+    odd_foe_spots.push_back(spot);
+}
+
+// The nearest living or generator that ob sees as a foe, closer than range
+walker* LevelData::find_nearest_foe(walker* ob, Sint32 range)
+{
+    walker* best = NULL;
+    Sint32 best_distance = range;
+    
+    if(!foes_indexed)
+        index_foes();
+    
+    walker* head = head_of_chain(ob);
+    bool hired = (head->myguy != NULL);
+    for(int t = 0; t <= MAX_TEAM; t++)
+    {
+        for(int h = 0; h < 2; h++)
+        {
+            // is_friendly calls everyone a foe of the dead
+            if(!foe_spots[t][h].empty() && (ob->dead || heads_are_foes(head->team_num, hired, t, h)))
+                search_foe_tree(foe_spots[t][h], 0, foe_spots[t][h].size(), 0, ob, best, best_distance);
+        }
+    }
+    
+    // Not in any tree, so these can be looked at where they are now
+    for(auto e = odd_foe_spots.begin(); e != odd_foe_spots.end(); e++)
+    {
+        walker* w = e->ob;
+        if(w->query_order() != ORDER_LIVING && w->query_order() != ORDER_GENERATOR)
+            continue;
+        Sint32 distance = abs(w->xpos - ob->xpos) + abs(w->ypos - ob->ypos);
+        if(distance < best_distance && foe_will_do(ob, w))
+        {
+            best = w;
+            best_distance = distance;
+        }
+    }
+    
+    return best;
+}
+
 void LevelData::delete_grid()
 {
     grid.free();
     pixmaxx = 0;
     pixmaxy = 0;
+    
+    delete_background();
+}
+
+// Render every grid cell into the background cache.  The cache is
+// rebuilt whenever the grid is replaced or resized; single cell edits
+// go through update_background() instead.
+void LevelData::build_background()
+{
+    delete_background();
+    
+    if(!grid.valid())
+        return;
+    
+    background_w = grid.w * GRID_SIZE;
+    background_h = grid.h * GRID_SIZE;
+    background = new unsigned char[background_w * background_h];
+    
+    for(int j = 0; j < grid.h; j++)
+    {
+        for(int i = 0; i < grid.w; i++)
+            update_background(i, j);
+    }
+    
+    build_radar_map();
+}
+
+void LevelData::build_radar_map()
+{
+    delete[] radar_map;
+    radar_map = NULL;
+    
+    if(!grid.valid())
+        return;
+    
+    radar_map = new unsigned char[grid.w * grid.h];
+    for(int i = 0; i < grid.w * grid.h; i++)
+        radar_map[i] = radar_terrain_color(grid.data[i]);
+}
+
+void LevelData::update_background(int x, int y)
+{
+    if(background == NULL || x < 0 || y < 0 || x >= grid.w || y >= grid.h)
+        return;
+    
+    unsigned char* target = &background[y*GRID_SIZE*background_w + x*GRID_SIZE];
+    const PixieData& tile = pixdata[(unsigned char)grid.data[y*grid.w + x]];
+    
+    if(radar_map)
+        radar_map[y*grid.w + x] = radar_terrain_color(grid.data[y*grid.w + x]);
+    
+    if(!tile.valid())
+    {
+        for(int j = 0; j < GRID_SIZE; j++)
+            memset(&target[j*background_w], 0, GRID_SIZE);
+        return;
+    }
+    
+    // Tiles are always GRID_SIZE square, but don't trust the file
+    int w = (tile.w < GRID_SIZE ? tile.w : GRID_SIZE);
+    int h = (tile.h < GRID_SIZE ? tile.h : GRID_SIZE);
+    for(int j = 0; j < h; j++)
+        memcpy(&target[j*background_w], &tile.data[j*tile.w], w);
+}
+
+void LevelData::delete_background()
+{
+    delete[] background;
+    background = NULL;
+    background_w = 0;
+    background_h = 0;
+    
+    delete[] radar_map;
+    radar_map = NULL;
 }
 
 void LevelData::create_new_grid()
@@ -449,6 +770,7 @@ void LevelData::create_new_grid()
     grid.h = 60;
 	pixmaxx = grid.w * GRID_SIZE;
 	pixmaxy = grid.h * GRID_SIZE;
+	myobmap->resize(pixmaxx, pixmaxy);
 	
 	int size = grid.w*grid.h;
     grid.data = new unsigned char[size];
@@ -471,6 +793,8 @@ void LevelData::create_new_grid()
             break;
         }
     }
+    
+    build_background();
 }
 
 void LevelData::resize_grid(int width, int height)
@@ -524,9 +848,12 @@ void LevelData::resize_grid(int width, int height)
     grid.h = height;
 	pixmaxx = grid.w * GRID_SIZE;
 	pixmaxy = grid.h * GRID_SIZE;
+	myobmap->resize(pixmaxx, pixmaxy);
     
+    build_background();
     
     // Delete objects that fell off the map
+    foes_indexed = false;
     int x = 0;
     int y = 0;
     int w = grid.w * GRID_SIZE;
@@ -594,32 +921,15 @@ void LevelData::delete_objects()
         delete *e;
     }
     dead_list.clear();
+    foes_indexed = false;
 
 	numobs = 0;
 	
     // Clear the obmap references
     // Since the walker destructor removes itself from the obmap, this should be empty already.
-    if(myobmap->walker_to_pos.size() > 0)
-    {
-        Log("obmap::walker_to_pos has %d elements left.\n", myobmap->walker_to_pos.size());
-        
-        // FIXME: Freeing them here does naughty things!
-        /*
-        std::vector<walker*> walkers;
-        for(auto e = myobmap->walker_to_pos.begin(); e != myobmap->walker_to_pos.end(); e++)
-        {
-            Log("Order: %d, Family: %d\n", e->first->query_order(), e->first->query_family());
-            walkers.push_back(e->first);
-        }
-        
-        for(auto e = walkers.begin(); e != walkers.end(); e++)
-        {
-            delete *e;
-        }*/
-    }
-    // pos_to_walker will have a bunch of 0-size lists in it
-	myobmap->pos_to_walker.clear();
-	myobmap->walker_to_pos.clear();
+    if(myobmap->size() > 0)
+        Log("obmap has %d walkers left.\n", (int) myobmap->size());
+    myobmap->clear();
 }
 
 short load_version_2(SDL_RWops  *infile, LevelData* data)
@@ -685,7 +995,7 @@ short load_version_2(SDL_RWops  *infile, LevelData* data)
 		}
 		new_guy ->setxy(currentx, currenty);
 		//       Log("X: %d  Y: %d  \n", currentx, currenty);
-		new_guy ->team_num = tempteam;
+		new_guy->set_team(tempteam);
 	}
 
 	// Now read the grid file to our master screen ..
@@ -778,7 +1088,7 @@ short load_version_3(SDL_RWops  *infile, LevelData* data)
 			return 0;
 		}
 		new_guy->setxy(currentx, currenty);
-		new_guy->team_num = tempteam;
+		new_guy->set_team(tempteam);
 		new_guy->stats->level = templevel;
 	}
 
@@ -883,7 +1193,7 @@ short load_version_4(SDL_RWops  *infile, LevelData* data)
 			return 0;
 		}
 		new_guy->setxy(currentx, currenty);
-		new_guy->team_num = tempteam;
+		new_guy->set_team(tempteam);
 		new_guy->stats->level = templevel;
 		strcpy(new_guy->stats->name, tempname);
 		if (strlen(tempname) > 1)                      //chad 5/25/95
@@ -996,7 +1306,7 @@ short load_version_5(SDL_RWops  *infile, LevelData* data)
 			return 0;
 		}
 		new_guy->setxy(currentx, currenty);
-		new_guy->team_num = tempteam;
+		new_guy->set_team(tempteam);
 		new_guy->stats->level = templevel;
 		strcpy(new_guy->stats->name, tempname);
 		if (strlen(tempname) > 1)                      //chad 5/25/95
@@ -1160,7 +1470,7 @@ short load_version_6(SDL_RWops  *infile, LevelData* data, short version)
         }
         
         new_guy->setxy(currentx, currenty);
-        new_guy->team_num = tempteam;
+        new_guy->set_team(tempteam);
         if (version >= 7)
             new_guy->stats->level = shortlevel;
         else
@@ -1302,6 +1612,9 @@ bool LevelData::load()
     short tempvalue = load_scenario_version(infile, this, versionnumber);
     SDL_RWclose(infile);
     
+    // The objects came before the grid, so fit the obmap now
+    myobmap->resize(pixmaxx, pixmaxy);
+    
     // Load background tiles
     {
         // Delete old tiles
@@ -1315,33 +1628,19 @@ bool LevelData::load()
                 back[i] = NULL;
             }
         }
+        tile_arena.free();
         
         // Load map data from a pixie format
-        load_map_data(pixdata);
+        load_map_data(pixdata, &tile_arena);
 
         // Initialize a pixie for each background piece
         for(int i = 0; i < PIX_MAX; i++)
             back[i] = new pixieN(pixdata[i], 0);
-
-        //buffers: after we set all the tiles to use acceleration, we go
-        //through the tiles that have pal cycling to turn of the accel.
-        back[PIX_WATER1]->set_accel(0);
-        back[PIX_WATER2]->set_accel(0);
-        back[PIX_WATER3]->set_accel(0);
-        back[PIX_WATERGRASS_LL]->set_accel(0);
-        back[PIX_WATERGRASS_LR]->set_accel(0);
-        back[PIX_WATERGRASS_UL]->set_accel(0);
-        back[PIX_WATERGRASS_UR]->set_accel(0);
-        back[PIX_WATERGRASS_U]->set_accel(0);
-        back[PIX_WATERGRASS_D]->set_accel(0);
-        back[PIX_WATERGRASS_L]->set_accel(0);
-        back[PIX_WATERGRASS_R]->set_accel(0);
-        back[PIX_GRASSWATER_LL]->set_accel(0);
-        back[PIX_GRASSWATER_LR]->set_accel(0);
-        back[PIX_GRASSWATER_UL]->set_accel(0);
-        back[PIX_GRASSWATER_UR]->set_accel(0);
     }
     
+    // Now that the grid and its tiles are both loaded
+    build_background();
+    
 	return (tempvalue != 0);
 }
 
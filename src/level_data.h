@@ -19,8 +19,10 @@
 #define _LEVEL_DATA_H__
 
 #include "SDL.h"
+#include "base.h"
 #include <list>
 #include <string>
+#include <vector>
 
 class screen;
 class pixie;
@@ -34,6 +36,13 @@ class obmap;
 #include "pixie_data.h"
 #include "pixdefs.h"
 
+// A possible foe and where its corner was when the foes were indexed
+struct FoeSpot
+{
+    Sint32 x, y;
+    walker* ob;
+};
+
 class CampaignData
 {
 public:
@@ -90,15 +99,40 @@ public:
     std::list<walker*> weaplist;  // weapons
     // Keep a list of dead guys so weapons can still have valid owners
     std::list<walker*> dead_list;
+    // Handed out as walker::draw_order, so walkers found through the
+    // obmap can be put back in list order for drawing
+    Uint32 next_draw_order;
     
     obmap* myobmap;
     std::list<std::string> description;
     
+    // Livings left in oblist, by team_num and by whether they're hired
+    // (have a myguy).  See count_living().
+    short living_count[MAX_TEAM+1][2];
+    
+    // Livings and generators in oblist, by the team and hire of the head
+    // of their owner chain, each set kept as a k-d tree for
+    // find_nearest_foe().  Indexed by index_foes() as each tick starts,
+    // so the trees hold where everyone stood then.
+    std::vector<FoeSpot> foe_spots[MAX_TEAM+1][2];
+    // Teams past MAX_TEAM, and walkers added or turned since the index
+    // (see late_foe()), searched one by one where they stand now
+    std::vector<FoeSpot> odd_foe_spots;
+    bool foes_indexed;
+    
     // Drawing details
     PixieData pixdata[PIX_MAX];
+    PixieArena tile_arena;  // holds all of pixdata
     pixieN* back[PIX_MAX];
     Sint32 topx, topy;
     
+    // The whole grid pre-rendered into 8-bit palette indices, so the
+    // viewscreens can blit it in one piece instead of tile by tile
+    unsigned char* background;
+    Sint32 background_w, background_h;
+    // One radar color per grid cell, shared by every radar on the level
+    unsigned char* radar_map;
+    
     LevelData(int id);
     ~LevelData();
     
@@ -109,10 +143,24 @@ public:
     walker* add_fx_ob(char order, char family);
     walker* add_weap_ob(char order, char family);
     short remove_ob(walker  *ob);
+    void prepare_frame(short views);  // walker::prepare_frame for everyone
+    
+    void count_living(walker* w);
+    short count_team(unsigned char team);
+    short count_foes(walker* myguy);
+    short count_foes_of_team(unsigned char team, bool frozen = false);
+    void index_foes();
+    void late_foe(walker* w);
+    walker* find_nearest_foe(walker* ob, Sint32 range);
     
     void create_new_grid();
     void resize_grid(int width, int height);
     void delete_grid();
+    
+    void build_background();
+    void update_background(int x, int y);  // Redraw one grid cell
+    void delete_background();
+    void build_radar_map();
     void delete_objects();
     void clear();
     
@@ -1311,7 +1311,7 @@ void LevelEditorData::activate_mode_button(SimpleButton* button)
                     if(obj->team_num > 0)
                         obj->team_num--;
                     else
-                        obj->team_num = MAX_TEAM;
+                        obj->set_team(MAX_TEAM);
                     levelchanged = 1;
                 }
             }
@@ -1336,7 +1336,7 @@ void LevelEditorData::activate_mode_button(SimpleButton* button)
                     if(obj->team_num < MAX_TEAM)
                         obj->team_num++;
                     else
-                        obj->team_num = 0;
+                        obj->set_team(0);
                     levelchanged = 1;
                 }
             }
@@ -1945,7 +1945,7 @@ Sint32 LevelEditorData::display_panel(screen* myscreen)
         newob->setxy(lm+25 + level->topx, PIX_TOP-16-1 + level->topy);
         newob->set_data(level->myloader->graphics[PIX(object_brush.order, object_brush.family)]);
         level->myloader->set_walker(newob, object_brush.order, object_brush.family);
-        newob->team_num = object_brush.team;
+        newob->set_team(object_brush.team);
         newob->draw_tile(myscreen->viewob[0]);
         // Border
         myscreen->draw_box(lm+25, PIX_TOP-16-1, lm+25+GRID_SIZE, PIX_TOP-16-1+GRID_SIZE, RED, 0, 1);
@@ -1965,7 +1965,7 @@ Sint32 LevelEditorData::display_panel(screen* myscreen)
                     newob->setxy(S_RIGHT+i*GRID_SIZE + level->topx, PIX_TOP+j*GRID_SIZE + level->topy);
                     newob->set_data(level->myloader->graphics[PIX(object_pane[index].order, object_pane[index].family)]);
                     level->myloader->set_walker(newob, object_pane[index].order, object_pane[index].family);
-                    newob->team_num = object_brush.team;
+                    newob->set_team(object_brush.team);
                     newob->draw_tile(myscreen->viewob[0]);
                 }
             }
@@ -1988,7 +1988,7 @@ Sint32 LevelEditorData::display_panel(screen* myscreen)
             newob->setxy(mx + level->topx, my + level->topy);
             newob->set_data(level->myloader->graphics[PIX(object_brush.order, object_brush.family)]);
             level->myloader->set_walker(newob, object_brush.order, object_brush.family);
-            newob->team_num = object_brush.team;
+            newob->set_team(object_brush.team);
             
             // Get size rounded up to nearest GRID_SIZE
             int w = newob->sizex;
@@ -2050,6 +2050,7 @@ void LevelEditorData::clear_terrain()
 void LevelEditorData::resmooth_terrain()
 {
     level->mysmoother.smooth();
+    level->build_background();
     myradar.update(level);
 }
 
@@ -3106,7 +3107,7 @@ void LevelEditorData::mouse_up(int mx, int my, int old_mx, int old_my, bool& don
                         levelchanged = 1;
                         newob = level->add_ob(object_brush.order, object_brush.family);
                         newob->setxy(windowx, windowy);
-                        newob->team_num = object_brush.team;
+                        newob->set_team(object_brush.team);
                         newob->stats->level = object_brush.level;
                         newob->dead = 0; // just in case
                         newob->collide_ob = 0;
@@ -3230,6 +3231,7 @@ void LevelEditorData::set_terrain(int x, int y, unsigned char terrain)
         return;
     
     level->grid.data[y*level->grid.w + x] = terrain;
+    level->update_background(x, y);
 }
 
 walker* LevelEditorData::get_object(int x, int y)
@@ -3921,10 +3923,12 @@ Sint32 level_editor()
                                         for (j=windowy-1; j <=windowy+1; j++)
                                             if (i >= 0 && i < data.level->grid.w &&
                                                     j >= 0 && j < data.level->grid.h)
+                                            {
                                                 data.level->mysmoother.smooth(i, j);
+                                                data.level->update_background(i, j);
+                                            }
                                 }
-                                
-                                myradar.update(data.level);
+                                // update_background() keeps the radar's terrain in step
                             }
                         }
                     }  // end of setting grid square
@@ -188,7 +188,7 @@ short living::act()
 		charm_left = 0;
 		if (real_team_num != 255)
 		{
-			team_num = real_team_num;
+			set_team(real_team_num);
 			real_team_num = 255;
 		}
 	}
@@ -593,8 +593,7 @@ short living::check_special()
 				}
 				else // get a new foe ..
 				{
-					myscreen->find_foes_in_range(myscreen->level_data.oblist,
-					                                        110, &howmany, this);
+					howmany = myscreen->find_foes_in_range(this, 110, myscreen->range_buffer);
 
 					if (howmany < 3)
 						return 0;
@@ -609,8 +608,7 @@ short living::check_special()
 				else               // charm
 					myrange = 16 + 4*stats->level;
 
-				myscreen->find_foes_in_range(myscreen->level_data.oblist,
-				                                        myrange, &howmany, this);
+				howmany = myscreen->find_foes_in_range(this, myrange, myscreen->range_buffer);
 				if (howmany < 1)
 					return 0;
 				else
@@ -620,8 +618,7 @@ short living::check_special()
 				return 1;  // default is go for it
 		case FAMILY_MAGE:  // TP if  away from guys ..
 			howmany = 0;
-			myscreen->find_foes_in_range(myscreen->level_data.oblist,
-			                                        110, &howmany, this);
+			howmany = myscreen->find_foes_in_range(this, 110, myscreen->range_buffer);
 
 			if (howmany < 1) //  away from anybody ..
 				return 1;
@@ -637,8 +634,7 @@ short living::check_special()
 		case FAMILY_CLERIC: // any friends?
 			if (current_special == 1) // healing
 			{
-				myscreen->find_friends_in_range(myscreen->level_data.oblist,
-				            60, &howmany, this);
+				howmany = myscreen->find_friends_in_range(this, 60, myscreen->range_buffer);
 
 				if (howmany > 1) // other than ourselves?
 				{
@@ -659,8 +655,7 @@ short living::check_special()
 			//break;
 		case FAMILY_SKELETON:  // Tunnel if no foes near ..
 			howmany = 0;
-			myscreen->find_foes_in_range(myscreen->level_data.oblist,
-			                                        5*GRID_SIZE, &howmany, this);
+			howmany = myscreen->find_foes_in_range(this, 5*GRID_SIZE, myscreen->range_buffer);
 
 			if (howmany < 1) //  away from anybody ..
 				return 1;      //  so tunnel
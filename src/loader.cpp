@@ -313,7 +313,7 @@ signed char  *anifood[] = { food1, food1, food1, food1,
                             food1, food1, food1, food1,
                             food1, food1, food1, food1 };
 
-PixieData data_copy(const PixieData& d)
+PixieData data_copy(const PixieData& d, PixieArena* arena)
 {
     PixieData result;
     
@@ -325,8 +325,10 @@ PixieData data_copy(const PixieData& d)
     result.h = d.h;
     
     Sint32 len = d.w * d.h * d.frames;
-    result.data = new unsigned char[len];
+    result.data = arena->alloc(len);
+    result.in_arena = true;
     memcpy(result.data, d.data, len);
+    result.compile_spans(true, arena);
     
     return result;
 }
@@ -351,27 +353,27 @@ loader::loader()
 
 
 	// Livings
-	graphics[PIX(ORDER_LIVING, FAMILY_SOLDIER)] = read_pixie_file("footman.pix");
-	graphics[PIX(ORDER_LIVING, FAMILY_ELF)] = read_pixie_file("elf.pix");
-	graphics[PIX(ORDER_LIVING, FAMILY_ARCHER)] = read_pixie_file("archer.pix");
-	graphics[PIX(ORDER_LIVING, FAMILY_THIEF)] = read_pixie_file("thief.pix");
-	graphics[PIX(ORDER_LIVING, FAMILY_MAGE)] = read_pixie_file("mage.pix");
-	graphics[PIX(ORDER_LIVING, FAMILY_SKELETON)] = read_pixie_file("skeleton.pix");
-	graphics[PIX(ORDER_LIVING, FAMILY_CLERIC)] = read_pixie_file("cleric.pix");
-	graphics[PIX(ORDER_LIVING, FAMILY_FIREELEMENTAL)] = read_pixie_file("firelem.pix");
-	graphics[PIX(ORDER_LIVING, FAMILY_FAERIE)] = read_pixie_file("faerie.pix");
-	graphics[PIX(ORDER_LIVING, FAMILY_SLIME)] = read_pixie_file("amoeba3.pix");
-	graphics[PIX(ORDER_LIVING, FAMILY_SMALL_SLIME)] = read_pixie_file("s_slime.pix");
-	graphics[PIX(ORDER_LIVING, FAMILY_MEDIUM_SLIME)] = read_pixie_file("m_slime.pix");
-	graphics[PIX(ORDER_LIVING, FAMILY_GHOST)] = read_pixie_file("ghost.pix");
-	graphics[PIX(ORDER_LIVING, FAMILY_DRUID)] = read_pixie_file("druid.pix");
-	graphics[PIX(ORDER_LIVING, FAMILY_ORC)] = read_pixie_file("orc.pix");
-	graphics[PIX(ORDER_LIVING, FAMILY_BIG_ORC)] = read_pixie_file("orc2.pix");
-	graphics[PIX(ORDER_LIVING, FAMILY_BARBARIAN)] = read_pixie_file("barby.pix");
-	graphics[PIX(ORDER_LIVING, FAMILY_ARCHMAGE)] = read_pixie_file("archmage.pix");
-	graphics[PIX(ORDER_LIVING, FAMILY_GOLEM)] = read_pixie_file("golem1.pix");
-	graphics[PIX(ORDER_LIVING, FAMILY_GIANT_SKELETON)] = read_pixie_file("gs1.pix");
-	graphics[PIX(ORDER_LIVING, FAMILY_TOWER1)] = read_pixie_file("towersm1.pix");
+	graphics[PIX(ORDER_LIVING, FAMILY_SOLDIER)] = read_pixie_file("footman.pix", &arena);
+	graphics[PIX(ORDER_LIVING, FAMILY_ELF)] = read_pixie_file("elf.pix", &arena);
+	graphics[PIX(ORDER_LIVING, FAMILY_ARCHER)] = read_pixie_file("archer.pix", &arena);
+	graphics[PIX(ORDER_LIVING, FAMILY_THIEF)] = read_pixie_file("thief.pix", &arena);
+	graphics[PIX(ORDER_LIVING, FAMILY_MAGE)] = read_pixie_file("mage.pix", &arena);
+	graphics[PIX(ORDER_LIVING, FAMILY_SKELETON)] = read_pixie_file("skeleton.pix", &arena);
+	graphics[PIX(ORDER_LIVING, FAMILY_CLERIC)] = read_pixie_file("cleric.pix", &arena);
+	graphics[PIX(ORDER_LIVING, FAMILY_FIREELEMENTAL)] = read_pixie_file("firelem.pix", &arena);
+	graphics[PIX(ORDER_LIVING, FAMILY_FAERIE)] = read_pixie_file("faerie.pix", &arena);
+	graphics[PIX(ORDER_LIVING, FAMILY_SLIME)] = read_pixie_file("amoeba3.pix", &arena);
+	graphics[PIX(ORDER_LIVING, FAMILY_SMALL_SLIME)] = read_pixie_file("s_slime.pix", &arena);
+	graphics[PIX(ORDER_LIVING, FAMILY_MEDIUM_SLIME)] = read_pixie_file("m_slime.pix", &arena);
+	graphics[PIX(ORDER_LIVING, FAMILY_GHOST)] = read_pixie_file("ghost.pix", &arena);
+	graphics[PIX(ORDER_LIVING, FAMILY_DRUID)] = read_pixie_file("druid.pix", &arena);
+	graphics[PIX(ORDER_LIVING, FAMILY_ORC)] = read_pixie_file("orc.pix", &arena);
+	graphics[PIX(ORDER_LIVING, FAMILY_BIG_ORC)] = read_pixie_file("orc2.pix", &arena);
+	graphics[PIX(ORDER_LIVING, FAMILY_BARBARIAN)] = read_pixie_file("barby.pix", &arena);
+	graphics[PIX(ORDER_LIVING, FAMILY_ARCHMAGE)] = read_pixie_file("archmage.pix", &arena);
+	graphics[PIX(ORDER_LIVING, FAMILY_GOLEM)] = read_pixie_file("golem1.pix", &arena);
+	graphics[PIX(ORDER_LIVING, FAMILY_GIANT_SKELETON)] = read_pixie_file("gs1.pix", &arena);
+	graphics[PIX(ORDER_LIVING, FAMILY_TOWER1)] = read_pixie_file("towersm1.pix", &arena);
 
     for(int i = 0; i < NUM_FAMILIES; i++)
     {
@@ -450,38 +452,38 @@ loader::loader()
 	lineofsight[PIX(ORDER_LIVING, FAMILY_TOWER1)] = 10;
 
 	// Weapons
-	graphics[PIX(ORDER_WEAPON, FAMILY_KNIFE)] = read_pixie_file("knife.pix");
-	graphics[PIX(ORDER_WEAPON, FAMILY_ROCK)] = read_pixie_file("rock.pix");
-	graphics[PIX(ORDER_WEAPON, FAMILY_ARROW)] = read_pixie_file("arrow.pix");
-	graphics[PIX(ORDER_WEAPON, FAMILY_FIRE_ARROW)] = read_pixie_file("farrow.pix");
-	graphics[PIX(ORDER_WEAPON, FAMILY_FIREBALL)] = read_pixie_file("fire.pix");
-	graphics[PIX(ORDER_WEAPON, FAMILY_TREE)] = read_pixie_file("tree.pix");
-	graphics[PIX(ORDER_WEAPON, FAMILY_METEOR)] = read_pixie_file("meteor.pix");
-	graphics[PIX(ORDER_WEAPON, FAMILY_SPRINKLE)] = read_pixie_file("sparkle.pix");
+	graphics[PIX(ORDER_WEAPON, FAMILY_KNIFE)] = read_pixie_file("knife.pix", &arena);
+	graphics[PIX(ORDER_WEAPON, FAMILY_ROCK)] = read_pixie_file("rock.pix", &arena);
+	graphics[PIX(ORDER_WEAPON, FAMILY_ARROW)] = read_pixie_file("arrow.pix", &arena);
+	graphics[PIX(ORDER_WEAPON, FAMILY_FIRE_ARROW)] = read_pixie_file("farrow.pix", &arena);
+	graphics[PIX(ORDER_WEAPON, FAMILY_FIREBALL)] = read_pixie_file("fire.pix", &arena);
+	graphics[PIX(ORDER_WEAPON, FAMILY_TREE)] = read_pixie_file("tree.pix", &arena);
+	graphics[PIX(ORDER_WEAPON, FAMILY_METEOR)] = read_pixie_file("meteor.pix", &arena);
+	graphics[PIX(ORDER_WEAPON, FAMILY_SPRINKLE)] = read_pixie_file("sparkle.pix", &arena);
 	
 	if(cfg.is_on("effects", "gore"))
     {
-        graphics[PIX(ORDER_WEAPON, FAMILY_BLOOD)] = read_pixie_file("blood.pix");
-        graphics[PIX(ORDER_TREASURE,FAMILY_STAIN)] = read_pixie_file("stain.pix");
+        graphics[PIX(ORDER_WEAPON, FAMILY_BLOOD)] = read_pixie_file("blood.pix", &arena);
+        graphics[PIX(ORDER_TREASURE,FAMILY_STAIN)] = read_pixie_file("stain.pix", &arena);
     }
 	else
     {
-        graphics[PIX(ORDER_WEAPON, FAMILY_BLOOD)] = read_pixie_file("blood_friendly.pix");
-        graphics[PIX(ORDER_TREASURE,FAMILY_STAIN)] = read_pixie_file("stain_friendly.pix");
+        graphics[PIX(ORDER_WEAPON, FAMILY_BLOOD)] = read_pixie_file("blood_friendly.pix", &arena);
+        graphics[PIX(ORDER_TREASURE,FAMILY_STAIN)] = read_pixie_file("stain_friendly.pix", &arena);
     }
         
-	graphics[PIX(ORDER_WEAPON, FAMILY_BONE)] = read_pixie_file("bone1.pix");
-	graphics[PIX(ORDER_WEAPON, FAMILY_BLOB)] = read_pixie_file("sl_ball.pix");
-	graphics[PIX(ORDER_WEAPON, FAMILY_LIGHTNING)] = read_pixie_file("lightnin.pix");
-	graphics[PIX(ORDER_WEAPON, FAMILY_GLOW)] = read_pixie_file("clerglow.pix");
-	graphics[PIX(ORDER_WEAPON, FAMILY_WAVE)] = read_pixie_file("wave.pix");
-	graphics[PIX(ORDER_WEAPON, FAMILY_WAVE2)] = read_pixie_file("wave2.pix");
-	graphics[PIX(ORDER_WEAPON, FAMILY_WAVE3)] = read_pixie_file("wave3.pix");
-	graphics[PIX(ORDER_WEAPON, FAMILY_CIRCLE_PROTECTION)] = read_pixie_file("wave2.pix");
-	graphics[PIX(ORDER_WEAPON, FAMILY_HAMMER)] = read_pixie_file("hammer.pix");
+	graphics[PIX(ORDER_WEAPON, FAMILY_BONE)] = read_pixie_file("bone1.pix", &arena);
+	graphics[PIX(ORDER_WEAPON, FAMILY_BLOB)] = read_pixie_file("sl_ball.pix", &arena);
+	graphics[PIX(ORDER_WEAPON, FAMILY_LIGHTNING)] = read_pixie_file("lightnin.pix", &arena);
+	graphics[PIX(ORDER_WEAPON, FAMILY_GLOW)] = read_pixie_file("clerglow.pix", &arena);
+	graphics[PIX(ORDER_WEAPON, FAMILY_WAVE)] = read_pixie_file("wave.pix", &arena);
+	graphics[PIX(ORDER_WEAPON, FAMILY_WAVE2)] = read_pixie_file("wave2.pix", &arena);
+	graphics[PIX(ORDER_WEAPON, FAMILY_WAVE3)] = read_pixie_file("wave3.pix", &arena);
+	graphics[PIX(ORDER_WEAPON, FAMILY_CIRCLE_PROTECTION)] = read_pixie_file("wave2.pix", &arena);
+	graphics[PIX(ORDER_WEAPON, FAMILY_HAMMER)] = read_pixie_file("hammer.pix", &arena);
 	
-	graphics[PIX(ORDER_WEAPON, FAMILY_DOOR)] = read_pixie_file("door.pix");
-	graphics[PIX(ORDER_WEAPON, FAMILY_BOULDER)] = read_pixie_file("boulder1.pix");
+	graphics[PIX(ORDER_WEAPON, FAMILY_DOOR)] = read_pixie_file("door.pix", &arena);
+	graphics[PIX(ORDER_WEAPON, FAMILY_BOULDER)] = read_pixie_file("boulder1.pix", &arena);
 
 	hitpoints[PIX(ORDER_WEAPON, FAMILY_KNIFE)] = 6;
 	hitpoints[PIX(ORDER_WEAPON, FAMILY_BONE)] = 5;
@@ -633,18 +635,18 @@ loader::loader()
 	fire_frequency[PIX(ORDER_WEAPON, FAMILY_BOULDER)] = 0;
 
 	// Treasure items (food, etc.)
-	graphics[PIX(ORDER_TREASURE, FAMILY_DRUMSTICK)] = read_pixie_file("food1.pix");
-	graphics[PIX(ORDER_TREASURE, FAMILY_GOLD_BAR)] = read_pixie_file("bar1.pix");
-	graphics[PIX(ORDER_TREASURE, FAMILY_SILVER_BAR)] = data_copy(graphics[PIX(ORDER_TREASURE, FAMILY_GOLD_BAR)]);
-	graphics[PIX(ORDER_TREASURE, FAMILY_MAGIC_POTION)] = read_pixie_file("bottle.pix");
-	graphics[PIX(ORDER_TREASURE, FAMILY_INVIS_POTION)] = data_copy(graphics[PIX(ORDER_TREASURE, FAMILY_MAGIC_POTION)]);
-	graphics[PIX(ORDER_TREASURE, FAMILY_INVULNERABLE_POTION)] = data_copy(graphics[PIX(ORDER_TREASURE, FAMILY_MAGIC_POTION)]);
-	graphics[PIX(ORDER_TREASURE, FAMILY_FLIGHT_POTION)] = data_copy(graphics[PIX(ORDER_TREASURE, FAMILY_MAGIC_POTION)]);
-	graphics[PIX(ORDER_TREASURE, FAMILY_EXIT)] = read_pixie_file("16exit1.pix");
-	graphics[PIX(ORDER_TREASURE, FAMILY_TELEPORTER)] = read_pixie_file("teleport.pix");
-	graphics[PIX(ORDER_TREASURE, FAMILY_LIFE_GEM)] = read_pixie_file("lifegem.pix");
-	graphics[PIX(ORDER_TREASURE, FAMILY_KEY)] = read_pixie_file("key.pix");
-	graphics[PIX(ORDER_TREASURE, FAMILY_SPEED_POTION)] = data_copy(graphics[PIX(ORDER_TREASURE, FAMILY_MAGIC_POTION)]);
+	graphics[PIX(ORDER_TREASURE, FAMILY_DRUMSTICK)] = read_pixie_file("food1.pix", &arena);
+	graphics[PIX(ORDER_TREASURE, FAMILY_GOLD_BAR)] = read_pixie_file("bar1.pix", &arena);
+	graphics[PIX(ORDER_TREASURE, FAMILY_SILVER_BAR)] = data_copy(graphics[PIX(ORDER_TREASURE, FAMILY_GOLD_BAR)], &arena);
+	graphics[PIX(ORDER_TREASURE, FAMILY_MAGIC_POTION)] = read_pixie_file("bottle.pix", &arena);
+	graphics[PIX(ORDER_TREASURE, FAMILY_INVIS_POTION)] = data_copy(graphics[PIX(ORDER_TREASURE, FAMILY_MAGIC_POTION)], &arena);
+	graphics[PIX(ORDER_TREASURE, FAMILY_INVULNERABLE_POTION)] = data_copy(graphics[PIX(ORDER_TREASURE, FAMILY_MAGIC_POTION)], &arena);
+	graphics[PIX(ORDER_TREASURE, FAMILY_FLIGHT_POTION)] = data_copy(graphics[PIX(ORDER_TREASURE, FAMILY_MAGIC_POTION)], &arena);
+	graphics[PIX(ORDER_TREASURE, FAMILY_EXIT)] = read_pixie_file("16exit1.pix", &arena);
+	graphics[PIX(ORDER_TREASURE, FAMILY_TELEPORTER)] = read_pixie_file("teleport.pix", &arena);
+	graphics[PIX(ORDER_TREASURE, FAMILY_LIFE_GEM)] = read_pixie_file("lifegem.pix", &arena);
+	graphics[PIX(ORDER_TREASURE, FAMILY_KEY)] = read_pixie_file("key.pix", &arena);
+	graphics[PIX(ORDER_TREASURE, FAMILY_SPEED_POTION)] = data_copy(graphics[PIX(ORDER_TREASURE, FAMILY_MAGIC_POTION)], &arena);
 
 	hitpoints[PIX(ORDER_TREASURE, FAMILY_DRUMSTICK)] = 10;
 	hitpoints[PIX(ORDER_TREASURE, FAMILY_GOLD_BAR)] = 1000;
@@ -679,10 +681,10 @@ loader::loader()
 	stepsizes[PIX(ORDER_TREASURE, FAMILY_DRUMSTICK)] = 5;
 
 	// Generator
-	graphics[PIX(ORDER_GENERATOR, FAMILY_TENT)] = read_pixie_file("tent.pix");
-	graphics[PIX(ORDER_GENERATOR, FAMILY_TOWER)] = read_pixie_file("tower4.pix");
-	graphics[PIX(ORDER_GENERATOR, FAMILY_BONES)] = read_pixie_file("bonepile.pix");
-	graphics[PIX(ORDER_GENERATOR, FAMILY_TREEHOUSE)] = read_pixie_file("bigtree.pix");
+	graphics[PIX(ORDER_GENERATOR, FAMILY_TENT)] = read_pixie_file("tent.pix", &arena);
+	graphics[PIX(ORDER_GENERATOR, FAMILY_TOWER)] = read_pixie_file("tower4.pix", &arena);
+	graphics[PIX(ORDER_GENERATOR, FAMILY_BONES)] = read_pixie_file("bonepile.pix", &arena);
+	graphics[PIX(ORDER_GENERATOR, FAMILY_TREEHOUSE)] = read_pixie_file("bigtree.pix", &arena);
 	hitpoints[PIX(ORDER_GENERATOR, FAMILY_TENT)] = 100;
 
 	act_types[PIX(ORDER_GENERATOR, FAMILY_TENT)] = ACT_GENERATE;
@@ -716,22 +718,22 @@ loader::loader()
 	fire_frequency[PIX(ORDER_GENERATOR, FAMILY_TREEHOUSE)] = 0;
 
 	// Specials ..
-	graphics[PIX(ORDER_SPECIAL, FAMILY_RESERVED_TEAM)] = read_pixie_file("team.pix");
+	graphics[PIX(ORDER_SPECIAL, FAMILY_RESERVED_TEAM)] = read_pixie_file("team.pix", &arena);
 
 	// Effects ..
-	graphics[PIX(ORDER_FX, FAMILY_EXPAND)] = read_pixie_file("expand8.pix");
-	graphics[PIX(ORDER_FX, FAMILY_GHOST_SCARE)]  = read_pixie_file("expand8.pix");
-	graphics[PIX(ORDER_FX, FAMILY_BOMB)]  = read_pixie_file("bomb1.pix");
-	graphics[PIX(ORDER_FX, FAMILY_EXPLOSION)]  = read_pixie_file("boom1.pix");
-	graphics[PIX(ORDER_FX, FAMILY_FLASH)]  = read_pixie_file("telflash.pix");
-	graphics[PIX(ORDER_FX, FAMILY_MAGIC_SHIELD)] = read_pixie_file("mshield.pix");
-	graphics[PIX(ORDER_FX, FAMILY_KNIFE_BACK)] = read_pixie_file("knife.pix");
-	graphics[PIX(ORDER_FX, FAMILY_CLOUD)] = read_pixie_file("cloud.pix");
-	graphics[PIX(ORDER_FX, FAMILY_MARKER)] = read_pixie_file("marker.pix");
-	graphics[PIX(ORDER_FX, FAMILY_BOOMERANG)] = read_pixie_file("boomer.pix");
-	graphics[PIX(ORDER_FX, FAMILY_CHAIN)] = read_pixie_file("lightnin.pix");
-	graphics[PIX(ORDER_FX, FAMILY_DOOR_OPEN)] = read_pixie_file("door.pix");
-	graphics[PIX(ORDER_FX, FAMILY_HIT)] = read_pixie_file("hit.pix");
+	graphics[PIX(ORDER_FX, FAMILY_EXPAND)] = read_pixie_file("expand8.pix", &arena);
+	graphics[PIX(ORDER_FX, FAMILY_GHOST_SCARE)]  = read_pixie_file("expand8.pix", &arena);
+	graphics[PIX(ORDER_FX, FAMILY_BOMB)]  = read_pixie_file("bomb1.pix", &arena);
+	graphics[PIX(ORDER_FX, FAMILY_EXPLOSION)]  = read_pixie_file("boom1.pix", &arena);
+	graphics[PIX(ORDER_FX, FAMILY_FLASH)]  = read_pixie_file("telflash.pix", &arena);
+	graphics[PIX(ORDER_FX, FAMILY_MAGIC_SHIELD)] = read_pixie_file("mshield.pix", &arena);
+	graphics[PIX(ORDER_FX, FAMILY_KNIFE_BACK)] = read_pixie_file("knife.pix", &arena);
+	graphics[PIX(ORDER_FX, FAMILY_CLOUD)] = read_pixie_file("cloud.pix", &arena);
+	graphics[PIX(ORDER_FX, FAMILY_MARKER)] = read_pixie_file("marker.pix", &arena);
+	graphics[PIX(ORDER_FX, FAMILY_BOOMERANG)] = read_pixie_file("boomer.pix", &arena);
+	graphics[PIX(ORDER_FX, FAMILY_CHAIN)] = read_pixie_file("lightnin.pix", &arena);
+	graphics[PIX(ORDER_FX, FAMILY_DOOR_OPEN)] = read_pixie_file("door.pix", &arena);
+	graphics[PIX(ORDER_FX, FAMILY_HIT)] = read_pixie_file("hit.pix", &arena);
 
 	animations[PIX(ORDER_FX, FAMILY_EXPAND)] = aniexpand8;
 	animations[PIX(ORDER_FX, FAMILY_GHOST_SCARE)] = aniexpand8;
@@ -760,10 +762,10 @@ loader::loader()
 	damage[PIX(ORDER_FX, FAMILY_CLOUD)] = 20;
 
 	// These are button graphics ..
-	graphics[PIX(ORDER_BUTTON1, FAMILY_NORMAL1)] = read_pixie_file("normal1.pix");
-	graphics[PIX(ORDER_BUTTON1, FAMILY_PLUS)] = read_pixie_file("butplus.pix");
-	graphics[PIX(ORDER_BUTTON1, FAMILY_MINUS)] = read_pixie_file("butminus.pix");
-	graphics[PIX(ORDER_BUTTON1, FAMILY_WRENCH)] = read_pixie_file("wrench.pix");
+	graphics[PIX(ORDER_BUTTON1, FAMILY_NORMAL1)] = read_pixie_file("normal1.pix", &arena);
+	graphics[PIX(ORDER_BUTTON1, FAMILY_PLUS)] = read_pixie_file("butplus.pix", &arena);
+	graphics[PIX(ORDER_BUTTON1, FAMILY_MINUS)] = read_pixie_file("butminus.pix", &arena);
+	graphics[PIX(ORDER_BUTTON1, FAMILY_WRENCH)] = read_pixie_file("wrench.pix", &arena);
 
 }
 
@@ -773,6 +775,7 @@ loader::~loader(void)
 	for(i=0;i<(SIZE_ORDERS*SIZE_FAMILIES);i++) {
 	    graphics[i].free();
 	}
+	arena.free();
 	
 	delete[] graphics;
 
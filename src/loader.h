@@ -31,6 +31,7 @@ class loader
 		pixieN *create_pixieN(char order, char family);
 		walker *set_walker(walker *ob, char order, char family);
 		PixieData* graphics;
+		PixieArena arena;  // holds all of 'graphics', in load order
 		signed char  ***animations;
 		float  *stepsizes;
 		Sint32  *lineofsight;
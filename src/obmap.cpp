@@ -21,7 +21,7 @@
 
 bool debug_draw_obmap = false;
 
-short ob_pass_check(short x, short y, walker  *ob, const std::list<walker*>& pile);
+short ob_pass_check(short x, short y, walker  *ob, const std::vector<walker*>& pile);
 short collide(short x,  short y,  short xsize,  short ysize,
               short x2, short y2, short xsize2, short ysize2);
 
@@ -34,8 +34,11 @@ obmap::obmap()
 {
 	obmapres = OBRES;
 	
-	pos_to_walker.clear();
-	walker_to_pos.clear();
+	// Sized for real by resize() once the level's size is known
+	cols = rows = 1;
+	piles.resize(1);
+	ignored.resize(1);
+	num_walkers = 0;
 }
 
 obmap::~obmap()
@@ -47,64 +50,33 @@ void obmap::draw()
     short offsetx = myscreen->viewob[0]->topx;
     short offsety = myscreen->viewob[0]->topy;
     // Draw the number of obs in each pile
-    for(auto e = pos_to_walker.begin(); e != pos_to_walker.end(); e++)
+    for(int i = 0; i < cols*rows; i++)
     {
-        short cx = unhash(e->first.first) - offsetx + OBRES/2;
-        short cy = unhash(e->first.second) - offsety + OBRES/2;
+        if(piles[i].empty())
+            continue;
+        short cx = (i % cols)*OBRES - offsetx + OBRES/2;
+        short cy = (i / cols)*OBRES - offsety + OBRES/2;
         myscreen->draw_box(cx - OBRES/2, cy - OBRES/2, cx + OBRES/2, cy + OBRES/2, YELLOW, false);
-        t.write_xy_center(cx, cy, YELLOW, "%d", e->second.size());
+        t.write_xy_center(cx, cy, YELLOW, "%d", piles[i].size());
     }
     
-    // Draw a box for each walker
-    for(auto e = walker_to_pos.begin(); e != walker_to_pos.end(); e++)
+    // Draw a box around the cells of each walker
+    std::vector<walker*> obs;
+    collect(piles, obs);
+    for(auto e = obs.begin(); e != obs.end(); e++)
     {
-        // Get bounds
-        bool unset = true;
-        SDL_Rect r = {0, 0, 1, 1};
-        for(auto f = e->second.begin(); f != e->second.end(); f++)
-        {
-            if(unset)
-            {
-                r.x = f->first;
-                r.y = f->second;
-                unset = false;
-                continue;
-            }
-            if(f->first < r.x)
-            {
-                r.w += r.x - f->first;
-                r.x = f->first;
-            }
-            if(f->second < r.y)
-            {
-                r.h += r.y - f->second;
-                r.y = f->second;
-            }
-            if(f->first > r.x + r.w)
-            {
-                r.w += f->first - (r.x + r.w);
-            }
-            if(f->second > r.y + r.h)
-            {
-                r.h += f->second - (r.y + r.h);
-            }
-        }
-        
-        if(!unset)
-        {
-            // Draw the rect
-            short x = unhash(r.x) - offsetx;
-            short y = unhash(r.y) - offsety;
-            short w = unhash(r.w);
-            short h = unhash(r.h);
-            myscreen->draw_box(x, y, x + w, y + h, e->first->query_team_color(), false);
-        }
+        walker* w = *e;
+        short x = w->obmap_x0*OBRES - offsetx;
+        short y = w->obmap_y0*OBRES - offsety;
+        short x2 = (w->obmap_x1 + 1)*OBRES - offsetx;
+        short y2 = (w->obmap_y1 + 1)*OBRES - offsety;
+        myscreen->draw_box(x, y, x2, y2, w->query_team_color(), false);
     }
 }
 
 size_t obmap::size() const
 {
-    return walker_to_pos.size();
+    return num_walkers;
 }
 
 short obmap::query_list(walker  *ob, short x, short y)
@@ -116,18 +88,18 @@ short obmap::query_list(walker  *ob, short x, short y)
 		Log("Bad ob to query_list.\n");
 		return 1;
 	}
-	startnumx = hash(x);
-	endnumx   = hash( (short) (x+ob->sizex) );
-	startnumy = hash(y);
-	endnumy   = hash( (short) (y+ob->sizey) );
+	startnumx = cell_x(x);
+	endnumx   = cell_x( (short) (x+ob->sizex) );
+	startnumy = cell_y(y);
+	endnumy   = cell_y( (short) (y+ob->sizey) );
 
 	// For each y grid row we are in...
-	for (numx = startnumx; numx <= endnumx; numx++)
+	for (numy = startnumy; numy <= endnumy; numy++)
 	{
-		for (numy = startnumy; numy <= endnumy; numy++)
+		for (numx = startnumx; numx <= endnumx; numx++)
 		{
 			// We should be finding the same item over and over
-			if (!ob_pass_check(x, y, ob, pos_to_walker[std::make_pair(numx, numy)] )) //&& ob->collide_ob??
+			if (!ob_pass_check(x, y, ob, piles[numy*cols + numx] )) //&& ob->collide_ob??
 				return 0;
 		}
 	}
@@ -137,106 +109,337 @@ short obmap::query_list(walker  *ob, short x, short y)
 
 short obmap::remove(walker  *ob)  // This goes in walker's destructor
 {
-    // Find all of the instances of the object and remove them from the map
+    // Whichever piles we were in
+    switch(ob->obmap_layer)
+    {
+        case OBMAP_PILES:
+            if(remove_from(piles, ob))
+                num_walkers--;
+            return true;
+        case OBMAP_IGNORED:
+            remove_from(ignored, ob);
+            return true;
+        default:
+            return false;
+    }
+}
+
+bool obmap::remove_from(std::vector<std::vector<walker*> >& cells, walker  *ob)
+{
+    bool found = false;
     
-    // Get the list of positions that the walker occupies
-    auto e = walker_to_pos.find(ob);
-    if(e != walker_to_pos.end())
+    // The block is only out of range if we were cleared away before
+    short endnumx = (ob->obmap_x1 < cols ? ob->obmap_x1 : cols - 1);
+    short endnumy = (ob->obmap_y1 < rows ? ob->obmap_y1 : rows - 1);
+    for(short numy = ob->obmap_y0; numy <= endnumy; numy++)
     {
-        // For each position...
-        for(auto f = e->second.begin(); f != e->second.end(); f++)
+        for(short numx = ob->obmap_x0; numx <= endnumx; numx++)
         {
-            // Get the pile
-            auto g = pos_to_walker.find(*f);
-            
-            // Find our guy in this pile and remove him
-            auto h = std::find(g->second.begin(), g->second.end(), ob);
-            if(h != g->second.end())
-                g->second.erase(h);
+            // Find our guy in this pile and fill his spot with the last one
+            std::vector<walker*>& pile = cells[numy*cols + numx];
+            for(size_t i = 0; i < pile.size(); i++)
+            {
+                if(pile[i] == ob)
+                {
+                    pile[i] = pile.back();
+                    pile.pop_back();
+                    found = true;
+                    break;
+                }
+            }
         }
-        
-        // Erase the walker from the walker map too
-        walker_to_pos.erase(e);
-        return true;
     }
     
-    return false;
+    ob->obmap_layer = OBMAP_NONE;
+    return found;
 }
 
+// Anyone partly or wholly off the top or left edge is kept in the edge
+// cells (cell_x and cell_y clamp), so they can still be found and drawn
 short obmap::add(walker  *ob, short x, short y)  // This goes in walker's constructor
 {
-	short numx, startnumx, endnumx;
-	short numy, startnumy, endnumy;
+	add_to(OBMAP_PILES, ob, x, y);
+	num_walkers++;
+	return 1;
+}
 
-	if (x < 0 || y < 0)
-		return 0;
+void obmap::add_to(char layer, walker  *ob, short x, short y)
+{
+	std::vector<std::vector<walker*> >& cells = (layer == OBMAP_IGNORED ? ignored : piles);
+
+	ob->obmap_x0 = cell_x(x);
+	ob->obmap_x1 = cell_x( (short) (x + ob->sizex) );
+	ob->obmap_y0 = cell_y(y);
+	ob->obmap_y1 = cell_y( (short) (y + ob->sizey) );
+	ob->obmap_layer = layer;
+
+	for (short numy = ob->obmap_y0; numy <= ob->obmap_y1; numy++)
+		for (short numx = ob->obmap_x0; numx <= ob->obmap_x1; numx++)
+			cells[numy*cols + numx].push_back(ob);
+}
+
+
+short obmap::move(walker* ob, short x, short y)  // This goes in walker's setxy
+{
+	return move_to(OBMAP_PILES, ob, x, y);
+}
 
-	startnumx = hash(x);
-	endnumx   = hash( (short) (x + ob->sizex) );
-	startnumy = hash(y);
-	endnumy   = hash( (short) (y + ob->sizey) );
+short obmap::move_ignored(walker* ob, short x, short y)
+{
+	return move_to(OBMAP_IGNORED, ob, x, y);
+}
 
-    // Figure out all of the positions that are occupied
-	std::list<std::pair<short,short> > pos;
-	for (numx = startnumx; numx <= endnumx; numx++)
+// Most steps stay inside the same cells, so only the cells that enter or
+// leave the walker's block are touched, and usually none are
+short obmap::move_to(char layer, walker* ob, short x, short y)
+{
+	// (A block past the edges was left from before the cells were cleared)
+	if (ob->obmap_layer != layer || ob->obmap_x1 >= cols || ob->obmap_y1 >= rows)
 	{
-		for (numy = startnumy; numy <= endnumy; numy++)
+		remove(ob);
+		add_to(layer, ob, x, y);
+		if (layer == OBMAP_PILES)
+			num_walkers++;
+		return 1;
+	}
+
+	short startnumx = cell_x(x);
+	short endnumx   = cell_x( (short) (x + ob->sizex) );
+	short startnumy = cell_y(y);
+	short endnumy   = cell_y( (short) (y + ob->sizey) );
+	short oldstartx = ob->obmap_x0, oldendx = ob->obmap_x1;
+	short oldstarty = ob->obmap_y0, oldendy = ob->obmap_y1;
+
+	// Do we really need to move?
+	if (startnumx == oldstartx && endnumx == oldendx
+	    && startnumy == oldstarty && endnumy == oldendy)
+		return 1;
+
+	std::vector<std::vector<walker*> >& cells = (layer == OBMAP_IGNORED ? ignored : piles);
+
+	// Leave the cells that aren't in the new block ..
+	for (short numy = oldstarty; numy <= oldendy; numy++)
+	{
+		for (short numx = oldstartx; numx <= oldendx; numx++)
 		{
-		    // Store this position
-		    pos.push_back(std::make_pair(numx, numy));
-		    
-		    // Put the walker here too
-		    pos_to_walker[std::make_pair(numx, numy)].push_back(ob);
+			if (numx >= startnumx && numx <= endnumx && numy >= startnumy && numy <= endnumy)
+				continue;
+			std::vector<walker*>& pile = cells[numy*cols + numx];
+			for (size_t i = 0; i < pile.size(); i++)
+			{
+				if (pile[i] == ob)
+				{
+					pile[i] = pile.back();
+					pile.pop_back();
+					break;
+				}
+			}
 		}
 	}
-	
-	// Now record where he is
-	walker_to_pos.insert(std::make_pair(ob, pos));
-		
+
+	// .. and join the ones that weren't in the old
+	for (short numy = startnumy; numy <= endnumy; numy++)
+		for (short numx = startnumx; numx <= endnumx; numx++)
+			if (numx < oldstartx || numx > oldendx || numy < oldstarty || numy > oldendy)
+				cells[numy*cols + numx].push_back(ob);
+
+	ob->obmap_x0 = startnumx;
+	ob->obmap_x1 = endnumx;
+	ob->obmap_y0 = startnumy;
+	ob->obmap_y1 = endnumy;
 	return 1;
 }
 
 
-short obmap::move(walker* ob, short x, short y)  // This goes in walker's setxy
+short obmap::cell_x(short x)
 {
-    // Do we really need to move?
-	if(x == ob->xpos && y == ob->ypos)
-        return 1;
-
-	remove(ob);
-	add(ob, x, y);
-	return 1;
+	short num = (short) (x/OBRES);
+	if (num >= cols)
+		num = cols - 1;
+	if (num < 0)
+		num = 0;
+	return num;
 }
 
-
-short obmap::hash(short y)
+short obmap::cell_y(short y)
 {
-	//  For now, this assumes no one is smaller than size 8
-	//  Also note that the hash table never loops.
-	// return (y/8);
-	short num = (short) (y/OBRES) ;
-	if (num > 198)
-		num = 199;
+	short num = (short) (y/OBRES);
+	if (num >= rows)
+		num = rows - 1;
 	if (num < 0)
-		num = 199;
+		num = 0;
 	return num;
 }
 
-short obmap::unhash(short y)
+// Gives every walker in these cells once: each one is listed by the
+// top left cell of its block
+void obmap::collect(std::vector<std::vector<walker*> >& cells, std::vector<walker*>& result)
+{
+	for (int i = 0; i < cols*rows; i++)
+		for (auto e = cells[i].begin(); e != cells[i].end(); e++)
+			if ((*e)->obmap_y0*cols + (*e)->obmap_x0 == i)
+				result.push_back(*e);
+}
+
+// Rebuilds the cells to cover the level, with everyone put back where they are
+void obmap::resize(Sint32 pixw, Sint32 pixh)
+{
+	// Walkers hang over the far edges by up to their size
+	short newcols = (short) (pixw/OBRES + 1);
+	short newrows = (short) (pixh/OBRES + 1);
+	if (newcols == cols && newrows == rows)
+		return;
+
+	std::vector<walker*> obs, ignored_obs;
+	collect(piles, obs);
+	collect(ignored, ignored_obs);
+
+	cols = newcols;
+	rows = newrows;
+	piles.assign(cols*rows, std::vector<walker*>());
+	ignored.assign(cols*rows, std::vector<walker*>());
+
+	for (auto e = obs.begin(); e != obs.end(); e++)
+		add_to(OBMAP_PILES, *e, (*e)->xpos, (*e)->ypos);
+	for (auto e = ignored_obs.begin(); e != ignored_obs.end(); e++)
+		add_to(OBMAP_IGNORED, *e, (*e)->xpos, (*e)->ypos);
+}
+
+// Forgets everyone without touching them; they may be gone already
+void obmap::clear()
+{
+	for (int i = 0; i < cols*rows; i++)
+	{
+		piles[i].clear();
+		ignored[i].clear();
+	}
+	num_walkers = 0;
+}
+
+const std::vector<walker*>& obmap::obmap_get_list(short x, short y)
+{
+	static const std::vector<walker*> nobody;
+	if (x < 0 || y < 0 || x/OBRES >= cols || y/OBRES >= rows)
+		return nobody;
+	return piles[(y/OBRES)*cols + x/OBRES];
+}
+
+// Fills result with every walker in the piles that overlap the pixel
+// rectangle, so callers can look at just the ones near an area rather
+// than whole object lists.  It's up to them to check the exact position.
+void obmap::query_rect(short x, short y, short w, short h, std::vector<walker*>& result, bool with_ignored)
+{
+	short startnumx, endnumx;
+	short startnumy, endnumy;
+
+	result.clear();
+	// No giving up on a rectangle off the top or left edge: whoever
+	// stands out there is in the edge cells, which cell_x/cell_y give us
+	if (w <= 0 || h <= 0)
+		return;
+
+	startnumx = cell_x(x);
+	endnumx   = cell_x( (short) (x + w - 1) );
+	startnumy = cell_y(y);
+	endnumy   = cell_y( (short) (y + h - 1) );
+
+	query_cells(piles, startnumx, endnumx, startnumy, endnumy, result);
+	if (with_ignored)
+		query_cells(ignored, startnumx, endnumx, startnumy, endnumy, result);
+}
+
+void obmap::query_cells(std::vector<std::vector<walker*> >& cells,
+                        short startnumx, short endnumx, short startnumy, short endnumy,
+                        std::vector<walker*>& result)
+{
+	for (short numy = startnumy; numy <= endnumy; numy++)
+	{
+		for (short numx = startnumx; numx <= endnumx; numx++)
+		{
+			std::vector<walker*>& pile = cells[numy*cols + numx];
+			for (auto e = pile.begin(); e != pile.end(); e++)
+			{
+				// Big guys sit in more than one cell; take them from the
+				// first one of theirs that the rect covers
+				walker* w = *e;
+				if ((w->obmap_x0 >= startnumx ? w->obmap_x0 : startnumx) == numx
+				    && (w->obmap_y0 >= startnumy ? w->obmap_y0 : startnumy) == numy)
+					result.push_back(w);
+			}
+		}
+	}
+}
+
+// Keeps a pixel coordinate on a grid of cells cells across
+static Sint32 clamp_coord(Sint32 v, short cells)
+{
+	if (v < 0)
+		return 0;
+	if (v >= cells*OBRES)
+		return cells*OBRES - 1;
+	return v;
+}
+
+// For sorting query_range's results; set just before the sort
+static walker* range_center = NULL;
+
+static bool nearer_to_center(walker* a, walker* b)
 {
-    return y*OBRES;
+	return range_center->distance_to_ob(a) < range_center->distance_to_ob(b);
 }
 
-std::list<walker*>& obmap::obmap_get_list(short x, short y)
+short obmap::query_range(walker  *ob, Sint32 range, char relation, Uint32 orders,
+                         std::vector<walker*>& result, bool by_distance)
 {
-	return pos_to_walker[std::make_pair(hash(x), hash(y))];
+	result.clear();
+	if (!ob || range < 0 || cols < 1 || rows < 1)
+		return 0;
+
+	// distance_to_ob() is |dx| + |dy| between the corners, so anyone in
+	// range has their corner in this square, and so sits in its cells.
+	// Work in Sint32, since some spells ask for the whole map.  Whoever
+	// is off an edge sits in the edge cells, so the square is clamped
+	// onto the grid rather than given up on.
+	short startnumx = cell_x((short) clamp_coord(ob->xpos - range, cols));
+	short endnumx   = cell_x((short) clamp_coord(ob->xpos + range, cols));
+	short startnumy = cell_y((short) clamp_coord(ob->ypos - range, rows));
+	short endnumy   = cell_y((short) clamp_coord(ob->ypos + range, rows));
+
+	query_cells(piles, startnumx, endnumx, startnumy, endnumy, result);
+	query_cells(ignored, startnumx, endnumx, startnumy, endnumy, result);
+
+	// Keep only the ones asked for, in place
+	size_t kept = 0;
+	for (size_t i = 0; i < result.size(); i++)
+	{
+		walker* w = result[i];
+		if (w->dead || !(orders & RANGE_ORDER(w->query_order())))
+			continue;
+		if (relation == RANGE_FOES && ob->is_friendly(w))
+			continue;
+		if (relation == RANGE_FRIENDS && !ob->is_friendly(w))
+			continue;
+		if (ob->distance_to_ob(w) > range)
+			continue;
+		result[kept++] = w;
+	}
+	result.resize(kept);
+
+	if (by_distance)
+	{
+		range_center = ob;
+		std::stable_sort(result.begin(), result.end(), nearer_to_center);
+		range_center = NULL;
+	}
+
+	return (short) kept;
 }
 
 /***********************************************
 **  All pass checking from here down.
 ***********************************************/
 
-short ob_pass_check(short x, short y, walker  *ob, const std::list<walker*>& pile)
+short ob_pass_check(short x, short y, walker  *ob, const std::vector<walker*>& pile)
 {
 	short oxsize, oysize;
 	short x2,y2,xsize2,ysize2;
@@ -254,10 +457,12 @@ short ob_pass_check(short x, short y, walker  *ob, const std::list<walker*>& pil
 	if(!ob)
         return 1;
 
-	// Check each object to see if sizes collide.
-	for(auto e = pile.begin(); e != pile.end(); e++)
+	// Check each object to see if sizes collide.  Eating, opening doors
+	// and colliding can move walkers in and out of this pile, so it's
+	// read by index rather than with an iterator.
+	for(size_t i = 0; i < pile.size(); i++)
 	{
-	    walker* w = *e;
+	    walker* w = pile[i];
 	    if (w != ob && !w->dead)
         {
             targetorder = w->query_order();
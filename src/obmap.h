@@ -20,8 +20,21 @@
 // Definition of OBMAP class
 
 #include "base.h"
-#include <map>
-#include <list>
+#include <vector>
+
+// Which layer of cells a walker is in (walker::obmap_layer)
+#define OBMAP_NONE 0
+#define OBMAP_PILES 1
+#define OBMAP_IGNORED 2
+
+// Who query_range keeps, by how they stand with the walker asking
+#define RANGE_ANYONE 0
+#define RANGE_FOES 1
+#define RANGE_FRIENDS 2
+
+// query_range's orders to keep, or'd together
+#define RANGE_ORDER(order) (1 << (order))
+#define RANGE_ALL_ORDERS 0xFFFF
 
 class obmap
 {
@@ -32,17 +45,41 @@ class obmap
 		short remove(walker  *ob);  // This goes in walker's destructor
 		short add(walker  *ob, short x, short y);  // This goes in walker's constructor
 		short move(walker  *ob, short x, short y);  // This goes in walker's setxy
-		std::list<walker*>& obmap_get_list(short x, short y); //Returns the list at x,y for fnf
+		short move_ignored(walker  *ob, short x, short y);  // setxy for walkers that don't collide
+		const std::vector<walker*>& obmap_get_list(short x, short y); //Returns the pile at x,y for fnf
+		// everyone near a pixel rect, once each; with_ignored for drawing
+		void query_rect(short x, short y, short w, short h, std::vector<walker*>& result, bool with_ignored = false);
+		// everyone alive within ob->distance_to_ob() range of ob, nearest first if by_distance;
+		// returns how many.  result is cleared first, so callers can keep one around
+		short query_range(walker  *ob, Sint32 range, char relation, Uint32 orders,
+		                  std::vector<walker*>& result, bool by_distance = false);
+		void resize(Sint32 pixw, Sint32 pixh);  // fit the cells to a level this many pixels big
+		void clear();
 		short obmapres;
 		size_t size() const;
 		void draw();
 		
-		std::map<std::pair<short, short>, std::list<walker*> > pos_to_walker;
-		std::map<walker*, std::list<std::pair<short, short> > > walker_to_pos;
-		
 	private:
-		short hash(short y);
-		short unhash(short y);
+		// One pile per OBRES square cell, row by row, covering the level.
+		// Walkers past the edges are kept in the edge cells.  Each walker
+		// records the block of cells it is in (walker::obmap_x0 ..), so
+		// it can be taken out without searching.
+		short cols, rows;
+		std::vector<std::vector<walker*> > piles;
+		// Walkers with 'ignore' set (stains, blood ..) are kept apart, so
+		// collisions never see them but drawing can still find them
+		std::vector<std::vector<walker*> > ignored;
+		size_t num_walkers;  // in 'piles'
+		
+		short cell_x(short x);
+		short cell_y(short y);
+		void add_to(char layer, walker  *ob, short x, short y);
+		short move_to(char layer, walker  *ob, short x, short y);
+		bool remove_from(std::vector<std::vector<walker*> >& cells, walker  *ob);
+		void collect(std::vector<std::vector<walker*> >& cells, std::vector<walker*>& result);
+		void query_cells(std::vector<std::vector<walker*> >& cells,
+		                 short startnumx, short endnumx, short startnumy, short endnumy,
+		                 std::vector<walker*>& result);
 };
 
 #endif
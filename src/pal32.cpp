@@ -26,7 +26,10 @@
 
 #include "pal32.h"
 #include <stdio.h>
+#include <string.h>
+#include <vector>
 #include "SDL_types.h"
+#include "base.h"
 
 char temppal[768];    // for loading, setting, etc.
 char gammapal[768];   // for gamma-correction
@@ -34,8 +37,20 @@ char gammapal[768];   // for gamma-correction
 //buffers: PORT: we need a palette to store the current palette
 char curpal[768];
 
+// curpal converted to the screen's pixel format; only rebuilt
+// after something has changed curpal
+Uint32 curpal_lookup[256];
+bool curpal_lookup_dirty = true;
+int curpal_lookup_serial = 0;
+SDL_PixelFormat *lookup_format = NULL;
+
 char our_pal_lookup(int index);
 
+// Inverse color map: 5 bits per channel -> closest index in our.pal
+unsigned char inversepal[32*32*32];
+char basepal[768];
+bool inversepal_ready = false;
+
 //
 // load_and_set_palette
 // Loads palette from file FILENAME,
@@ -126,6 +141,7 @@ short set_palette(unsigned char *newpalette)
 	// Copy over the palette info ..
 	for (i=0; i < 768; i++)
 		curpal[i] = newpalette[i];
+	curpal_lookup_dirty = true;
 
 	return 1;
 }
@@ -158,6 +174,7 @@ void adjust_palette(unsigned char *whichpal, short amount)
 		// Now set the current palette index to modified bit value
 		curpal[i] = (char) tempcol;
 	}
+	curpal_lookup_dirty = true;
 }
 
 //
@@ -201,6 +218,37 @@ void cycle_palette(unsigned char *newpalette, short start, short end, short shif
 		//buffers: copy it over to ourpal.
 		curpal[i] = temppal[i];
 	}
+	curpal_lookup_dirty = true;
+}
+
+//
+// rotate_palette_regs
+// Color cycling: moves registers start..end-1 up by one and wraps
+//  end around to start.  The native lookup is rotated along with
+//  them, so the frame picks the new colors up when it's resolved
+//  without rebuilding the whole lookup.
+//
+void rotate_palette_regs(unsigned char start, unsigned char end)
+{
+	char tempcol[3];
+	Uint32 templookup;
+	int i;
+
+	if (end <= start)
+		return;
+
+	memcpy(tempcol, &curpal[end*3], 3);
+	memmove(&curpal[(start+1)*3], &curpal[start*3], (end-start)*3);
+	memcpy(&curpal[start*3], tempcol, 3);
+
+	if (curpal_lookup_dirty)
+		return; // rebuilt from curpal on the next query anyway
+
+	templookup = curpal_lookup[end];
+	for (i=end; i > start; i--)
+		curpal_lookup[i] = curpal_lookup[i-1];
+	curpal_lookup[start] = templookup;
+	curpal_lookup_serial++;
 }
 
 void query_palette_reg(unsigned char index, int *red, int *green, int *blue)
@@ -221,6 +269,221 @@ void set_palette_reg(unsigned char index,int red,int green,int blue)
 	curpal[index*3] = red;
 	curpal[index*3+1] = green;
 	curpal[index*3+2] = blue;
+	curpal_lookup_dirty = true;
+}
+
+void query_palette(unsigned char *whichpal)
+{
+	memcpy(whichpal, curpal, 768);
+}
+
+//
+// set_mixed_palette
+// Sets the current palette amount/total of the way from frompal
+//  to topal.  Fades only need these 768 values changed per step;
+//  the frame is recolored when it's resolved.
+//
+void set_mixed_palette(const unsigned char *frompal, const unsigned char *topal, int amount, int total)
+{
+	int i;
+
+	if (amount < 0)
+		amount = 0;
+	if (amount > total)
+		amount = total;
+
+	for (i=0; i < 768; i++)
+		curpal[i] = (char) (frompal[i] + (topal[i] - frompal[i]) * amount / total);
+	curpal_lookup_dirty = true;
+}
+
+void set_palette_lookup_format(SDL_PixelFormat *format)
+{
+	lookup_format = format;
+	curpal_lookup_dirty = true;
+}
+
+//
+// query_palette_lookup
+// Returns the 256 current palette colors in the lookup format
+//  (ARGB8888 if none was set), rebuilding them only if the
+//  palette changed since the last call
+//
+const Uint32 *query_palette_lookup()
+{
+	int i, r, g, b;
+
+	if (!curpal_lookup_dirty)
+		return curpal_lookup;
+
+	for (i=0; i < 256; i++)
+	{
+		r = curpal[i*3] * 4;
+		g = curpal[i*3+1] * 4;
+		b = curpal[i*3+2] * 4;
+		if (lookup_format)
+			curpal_lookup[i] = SDL_MapRGB(lookup_format, r, g, b);
+		else
+			curpal_lookup[i] = 0xFF000000 | (r << 16) | (g << 8) | b;
+	}
+	curpal_lookup_dirty = false;
+	curpal_lookup_serial++;
+
+	return curpal_lookup;
+}
+
+// query_palette_serial
+// Tells whether colors resolved through the lookup are stale:
+//  the number changes every time query_palette_lookup rebuilds it
+int query_palette_serial()
+{
+	return curpal_lookup_serial;
+}
+
+//
+// build_inverse_palette
+// Fills inversepal with the closest our.pal color for every
+//  15-bit rgb value.  Cycling colors are skipped so blended
+//  pixels don't start flowing like water.
+//
+void build_inverse_palette()
+{
+	int r, g, b, i;
+	int dr, dg, db, dist, bestdist;
+
+	for (i=0; i < 768; i++)
+		basepal[i] = our_pal_lookup(i);
+
+	for (r=0; r < 32; r++)
+		for (g=0; g < 32; g++)
+			for (b=0; b < 32; b++)
+			{
+				bestdist = 0x7FFFFFFF;
+				for (i=0; i < 256; i++)
+				{
+					if (i >= WATER_START && i <= ORANGE_END)
+						continue;
+					dr = basepal[i*3] - (r*2 + 1);
+					dg = basepal[i*3+1] - (g*2 + 1);
+					db = basepal[i*3+2] - (b*2 + 1);
+					dist = dr*dr*3 + dg*dg*4 + db*db*2;
+					if (dist < bestdist)
+					{
+						bestdist = dist;
+						inversepal[(r<<10) | (g<<5) | b] = (unsigned char) i;
+					}
+				}
+			}
+
+	inversepal_ready = true;
+}
+
+// Built on first use otherwise, which is only safe on one thread
+void ready_inverse_palette()
+{
+	if (!inversepal_ready)
+		build_inverse_palette();
+}
+
+// Takes 6-bit (0-63) palette values, like query_palette_reg gives
+unsigned char nearest_palette_index(int red, int green, int blue)
+{
+	ready_inverse_palette();
+
+	if (red < 0) red = 0;
+	if (red > 63) red = 63;
+	if (green < 0) green = 0;
+	if (green > 63) green = 63;
+	if (blue < 0) blue = 0;
+	if (blue > 63) blue = 63;
+
+	return inversepal[((red>>1)<<10) | ((green>>1)<<5) | (blue>>1)];
+}
+
+//
+// blend_palette_index
+// Mixes src over dest by alpha/256 in our.pal color space
+//  and returns the closest color index to the result
+//
+unsigned char blend_palette_index(unsigned char dest, unsigned char src, Uint8 alpha)
+{
+	int r, g, b;
+
+	if (alpha == 255)
+		return src;
+	ready_inverse_palette();
+
+	r = basepal[dest*3]   + (((basepal[src*3]   - basepal[dest*3])   * alpha) >> 8);
+	g = basepal[dest*3+1] + (((basepal[src*3+1] - basepal[dest*3+1]) * alpha) >> 8);
+	b = basepal[dest*3+2] + (((basepal[src*3+2] - basepal[dest*3+2]) * alpha) >> 8);
+
+	return nearest_palette_index(r, g, b);
+}
+
+//
+// query_blend_table
+// Returns blend_palette_index for every dest and src at this alpha,
+//  as a table indexed [src*256 + dest].  Row src is the fill table
+//  for a constant color.  The last few tables used are kept around.
+//  While held (several viewscreens drawing at once) a table that gets
+//  replaced is only retired, and freed on release.
+//
+#define BLEND_TABLES 8
+unsigned char *blend_tables[BLEND_TABLES];
+int blend_table_alpha[BLEND_TABLES] = {-1,-1,-1,-1,-1,-1,-1,-1};
+int blend_table_next = 0;
+SDL_SpinLock blend_table_lock = 0;
+int blend_tables_held = 0;
+std::vector<unsigned char*> retired_blend_tables;
+
+const unsigned char *query_blend_table(Uint8 alpha)
+{
+	int i, src, dest;
+	unsigned char *table;
+
+	SDL_AtomicLock(&blend_table_lock);
+	for (i=0; i < BLEND_TABLES; i++)
+		if (blend_table_alpha[i] == alpha)
+		{
+			table = blend_tables[i];
+			SDL_AtomicUnlock(&blend_table_lock);
+			return table;
+		}
+
+	i = blend_table_next;
+	blend_table_next = (blend_table_next + 1) % BLEND_TABLES;
+	if (blend_tables[i] && blend_tables_held)
+	{
+		retired_blend_tables.push_back(blend_tables[i]);
+		blend_tables[i] = NULL;
+	}
+	if (!blend_tables[i])
+		blend_tables[i] = new unsigned char[256*256];
+	table = blend_tables[i];
+
+	for (src=0; src < 256; src++)
+		for (dest=0; dest < 256; dest++)
+			table[src*256 + dest] = blend_palette_index(dest, src, alpha);
+	blend_table_alpha[i] = alpha;
+
+	SDL_AtomicUnlock(&blend_table_lock);
+	return table;
+}
+
+void hold_blend_tables()
+{
+	blend_tables_held++;
+}
+
+void release_blend_tables()
+{
+	int i;
+
+	if (--blend_tables_held > 0)
+		return;
+	for (i=0; i < (int) retired_blend_tables.size(); i++)
+		delete[] retired_blend_tables[i];
+	retired_blend_tables.clear();
 }
 
 //buffers: this is the our.pal data in a function.
@@ -22,6 +22,7 @@
 //the above is included in palette.cpp now
 
 #include "SDL_types.h"
+#include "SDL.h"
 
 short load_and_set_palette(const char *filename,unsigned char  *newpalette); // load/set palette from disk
 short load_palette(const char *filename,unsigned char *newpalette); // load palette from disk
@@ -31,5 +32,19 @@ void cycle_palette(unsigned char *newpalette, short start, short end, short shif
 
 void query_palette_reg(unsigned char index, int *red, int *green, int *blue);
 void set_palette_reg(unsigned char index,int red,int green,int blue);
+void rotate_palette_regs(unsigned char start, unsigned char end); // cycle without a lookup rebuild
 short save_palette(unsigned char * whatpalette);
+void query_palette(unsigned char *whichpal); // copy out the current palette
+void set_mixed_palette(const unsigned char *frompal, const unsigned char *topal, int amount, int total); // amount/total of the way
+
+void set_palette_lookup_format(SDL_PixelFormat *format); // native format for the lookup
+const Uint32 *query_palette_lookup(); // current palette in native format, cached
+int query_palette_serial(); // changes each time the lookup is rebuilt
+
+void ready_inverse_palette(); // build it now, before other threads may look
+unsigned char nearest_palette_index(int red, int green, int blue); // closest non-cycling color
+unsigned char blend_palette_index(unsigned char dest, unsigned char src, Uint8 alpha);
+const unsigned char *query_blend_table(Uint8 alpha); // [src*256 + dest] -> blend_palette_index
+void hold_blend_tables(); // keep returned tables alive until released
+void release_blend_tables();
 
@@ -65,6 +65,7 @@ bool cfg_store::load_settings()
     apply_setting("graphics", "render", "normal");
     apply_setting("graphics", "fullscreen", "off");
     apply_setting("graphics", "overscan_percentage", "0");
+    apply_setting("graphics", "record_every", "2");
     
     apply_setting("effects", "gore", "on");
     apply_setting("effects", "mini_hp_bar", "on");
@@ -187,6 +188,7 @@ void cfg_store::commandline(int &argc, char **&argv)
 "  -e		Use eagle engine for pixel doubling\n"
 "  -i		Use sai2x engine for pixel doubling\n"
 "  -f		Use full screen\n"
+"  -H		Run without a window (headless)\n"
 "  -h		Print a summary of the options\n"
 "  -v		Print the version number\n";
 
@@ -241,6 +243,10 @@ void cfg_store::commandline(int &argc, char **&argv)
 					data["graphics"]["fullscreen"] = "on";
 					Log("Running in fullscreen mode.");
 					break;
+				case 'H':
+					data["graphics"]["render"] = "headless";
+					Log("Running without a window (headless mode).");
+					break;
 				default:
 					Log("Unknown argument %s ignored.", argv[argnum]);
 			}
@@ -913,7 +913,10 @@ Sint32 create_team_menu(Sint32 arg1)
 	if (localbuttons)
 		delete localbuttons;
 
-	myscreen->fadeblack(0);
+	// Cross-fade from the last menu instead of going through black
+	unsigned char* last_frame = new unsigned char[320*200];
+	memcpy(last_frame, myscreen->getbuffer(), 320*200);
+	myscreen->clearbuffer();
 	
 	text& mytext = myscreen->text_normal;
 	
@@ -926,7 +929,8 @@ Sint32 create_team_menu(Sint32 arg1)
 	
 	int last_level_id = -1;
 	
-	myscreen->fadeblack(1);
+	myscreen->crossfade(last_frame);
+	delete[] last_frame;
 	
 	while ( !(retvalue & EXIT) )
 	{
@@ -2694,7 +2698,7 @@ void show_guy(Sint32 frames, Sint32 who, short centerx, short centery) // shows
 	for (i=0; i <= (frames/12)%4; i++)
 		mywalker->animate();
 	//mywalker->team_num = ourteam[editguy]->teamnum;
-	mywalker->team_num = current_guy->teamnum;
+	mywalker->set_team(current_guy->teamnum);
 
 	mywalker->setxy(centerx - (mywalker->sizex/2), centery - (mywalker->sizey/2));
 	myscreen->draw_button(centerx - 80 + 54, centery - 45 + 26, centerx - 80 + 106, centery - 45 + 64, 1, 1);
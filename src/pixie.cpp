@@ -21,6 +21,7 @@
 		*include cleanup
 	buffers: 8/8/02:
 		*changed the SDL surfaces to 24bit
+	bmp_surface is 8-bit again now that the framebuffer is indexed
 */
 #include "graph.h"
 
@@ -73,6 +74,8 @@ pixie::~pixie()
 void pixie::set_data(const PixieData& data)
 {
 	bmp = data.data;
+	spans = data.spans;
+	bmp_spans = data.frame_spans(0);
 	sizex = data.w;
 	sizey = data.h;
 	size = (unsigned short) (sizex*sizey);
@@ -100,6 +103,14 @@ short pixie::draw(short x, short y, viewscreen  * view_buf)
 }
 
 short pixie::draw(viewscreen * view_buf)
+{
+	return draw_at(xpos, ypos, view_buf);
+}
+
+// Like draw(x, y, view_buf), but without moving the pixie there, so a
+// shared pixie (like the level's wall tiles) can be drawn by several
+// viewscreens at once
+short pixie::draw_at(short x, short y, viewscreen * view_buf)
 {
 	Sint32 xscreen, yscreen;
 
@@ -108,8 +119,8 @@ short pixie::draw(viewscreen * view_buf)
 	//we actually don't need to waste time on the above since the clipper
 	//will handle it
 
-	xscreen = (Sint32) (xpos - view_buf->topx + view_buf->xloc);
-	yscreen = (Sint32) (ypos - view_buf->topy + view_buf->yloc);
+	xscreen = (Sint32) (x - view_buf->topx + view_buf->xloc);
+	yscreen = (Sint32) (y - view_buf->topy + view_buf->yloc);
 
 	if(accel)
 	{
@@ -148,10 +159,16 @@ short pixie::drawMix(viewscreen * view_buf)
 	xscreen = (Sint32) (xpos - view_buf->topx + view_buf->xloc);
 	yscreen = (Sint32) (ypos - view_buf->topy + view_buf->yloc);
 
-	myscreen->walkputbuffer(xscreen, yscreen, sizex, sizey,
-	                                 view_buf->xloc, view_buf->yloc,
-	                                 view_buf->endx, view_buf->endy,
-	                                 bmp, RED);
+	if(bmp_spans)
+		myscreen->walkputspans(xscreen, yscreen, sizex, sizey,
+		                                 view_buf->xloc, view_buf->yloc,
+		                                 view_buf->endx, view_buf->endy,
+		                                 bmp_spans, RED);
+	else
+		myscreen->walkputbuffer(xscreen, yscreen, sizex, sizey,
+		                                 view_buf->xloc, view_buf->yloc,
+		                                 view_buf->endx, view_buf->endy,
+		                                 bmp, RED);
 
 	return 1;
 }
@@ -196,30 +213,21 @@ short pixie::on_screen(viewscreen  *viewp)
 }
 
 //buffers: this func initializes the bmp_surface
+// The surface keeps the raw palette indices, like the framebuffer.
 void pixie::init_sdl_surface(void)
 {
-	int r,g,b,c,i,j,num;
-	SDL_Rect rect;
+	int i;
 
-	bmp_surface = SDL_CreateRGBSurface(SDL_SWSURFACE,sizex,sizey,32,
+	bmp_surface = SDL_CreateRGBSurface(SDL_SWSURFACE,sizex,sizey,8,
 	                                   0,0,0,0);
 	if(!bmp_surface)
 	{
 		Log("ERROR: pixie::init_sdl_surface(): could not create bmp_surface\n");
+		return;
 	}
 
-	num=0;
 	for(i=0;i<sizey;i++)
-		for(j=0;j<sizex;j++)
-		{
-			query_palette_reg(bmp[num],&r,&g,&b);
-			c = SDL_MapRGB(bmp_surface->format,r*4,g*4,b*4);
-			rect.x = j;
-			rect.y = i;
-			rect.w = rect.h = 1;
-			SDL_FillRect(bmp_surface,&rect,c);
-			num++;
-		}
+		memcpy((Uint8 *)bmp_surface->pixels + i*bmp_surface->pitch, &bmp[i*sizex], sizex);
 
 	accel = 1;
 }
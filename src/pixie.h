@@ -31,6 +31,7 @@ class pixie
 		virtual short move (short x, short y);
 		short draw (viewscreen  *view_buf);
 		short draw (short x, short y, viewscreen  *view_buf);
+		short draw_at (short x, short y, viewscreen  *view_buf);
 		short drawMix (viewscreen *view_buf);
 		short drawMix (short x, short y, viewscreen *view_buf);
 		short put_screen(short x, short y);
@@ -47,6 +48,8 @@ class pixie
 	protected:
 		unsigned short size;
 		unsigned char  *bmp,  *oldbmp;
+		//compiled opaque spans of every frame, and of the current one
+		unsigned char  *spans,  *bmp_spans;
 		//buffers: same data as bmp but in a convient SDL_Surface
 		SDL_Surface *bmp_surface;
 };
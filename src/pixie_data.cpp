@@ -16,15 +16,61 @@
  */
 
 #include "pixie_data.h"
+#include "SDL.h"
 #include <cstdlib>
+#include <cstring>
+#include <vector>
+#include <list>
+#include <map>
+
+
+static void forget_team_spans(unsigned char* spans, int frames, int h);
+
+// Most sprites are much smaller; bigger ones get a block of their own
+#define ARENA_BLOCK_SIZE (256*1024)
+
+PixieArena::PixieArena()
+    : block_used(0), block_size(0)
+{}
+
+PixieArena::~PixieArena()
+{
+    free();
+}
+
+unsigned char* PixieArena::alloc(size_t size)
+{
+    // Keep the span offsets aligned
+    size = (size + 7) & ~size_t(7);
+    
+    if(blocks.empty() || block_used + size > block_size)
+    {
+        block_size = (size > ARENA_BLOCK_SIZE ? size : ARENA_BLOCK_SIZE);
+        blocks.push_back(new unsigned char[block_size]);
+        block_used = 0;
+    }
+    
+    unsigned char* result = blocks.back() + block_used;
+    block_used += size;
+    return result;
+}
+
+void PixieArena::free()
+{
+    for(size_t i = 0; i < blocks.size(); i++)
+        delete[] blocks[i];
+    blocks.clear();
+    block_used = 0;
+    block_size = 0;
+}
 
 
 PixieData::PixieData()
-    : frames(0), w(0), h(0), data(NULL)
+    : frames(0), w(0), h(0), data(NULL), spans(NULL), in_arena(false)
 {}
 
 PixieData::PixieData(unsigned char frames, unsigned char w, unsigned char h, unsigned char* data)
-    : frames(frames), w(w), h(h), data(data)
+    : frames(frames), w(w), h(h), data(data), spans(NULL), in_arena(false)
 {}
 
 bool PixieData::valid() const
@@ -32,19 +78,270 @@ bool PixieData::valid() const
     return (data != NULL && frames != 0 && w != 0 && h != 0);
 }
 
+// Compiles the frames into runs of opaque pixels so the blitters can
+// skip transparency without testing every byte.
+// Layout: one offset per frame, then for each frame one offset per row
+// (relative to the frame), then the rows themselves:
+//   <# of spans> 1 byte
+//   per span: <skip> <run> <team> 1 byte each, then <run> bytes
+// skip counts transparent pixels since the end of the last span.  Runs
+// never mix team colors (>247) with normal ones, so a span is either
+// copied straight or recolored as a whole.  Data that was recolored
+// already is compiled without team_colors, so nothing is remapped.
+void PixieData::compile_spans(bool team_colors, PixieArena* arena)
+{
+    forget_team_spans(spans, frames, h);
+    if(!in_arena)
+        delete[] spans;
+    spans = NULL;
+    if(!valid())
+        return;
+    
+    std::vector<unsigned char> out(frames*sizeof(unsigned int));
+    unsigned char* src = data;
+    
+    for(int f = 0; f < frames; f++)
+    {
+        while(out.size() % sizeof(unsigned int))
+            out.push_back(0);
+        unsigned int frame_start = out.size();
+        memcpy(&out[f*sizeof(unsigned int)], &frame_start, sizeof(unsigned int));
+        out.resize(out.size() + h*sizeof(unsigned int));
+        
+        for(int y = 0; y < h; y++, src += w)
+        {
+            unsigned int row_start = out.size() - frame_start;
+            memcpy(&out[frame_start + y*sizeof(unsigned int)], &row_start, sizeof(unsigned int));
+            
+            size_t count_pos = out.size();
+            out.push_back(0);
+            int x = 0, last = 0;
+            while(x < w)
+            {
+                if(src[x] == 0)
+                {
+                    x++;
+                    continue;
+                }
+                
+                bool team = (team_colors && src[x] > 247);
+                int start = x;
+                while(x < w && src[x] != 0 && (team_colors && src[x] > 247) == team)
+                    x++;
+                
+                out.push_back(start - last);
+                out.push_back(x - start);
+                out.push_back(team);
+                out.insert(out.end(), src + start, src + x);
+                out[count_pos]++;
+                last = x;
+            }
+        }
+    }
+    
+    if(arena != NULL)
+        spans = arena->alloc(out.size());
+    else
+        spans = new unsigned char[out.size()];
+    memcpy(spans, &out[0], out.size());
+}
+
+unsigned char* PixieData::frame_spans(int frame) const
+{
+    return frame_spans(spans, frame);
+}
+
+unsigned char* PixieData::frame_spans(unsigned char* spans, int frame)
+{
+    if(spans == NULL)
+        return NULL;
+    return spans + ((unsigned int*)spans)[frame];
+}
+
+
+// Team recoloring cache
+// Walkers of every team share the same frames, so the team colors
+// (>247) used to be remapped on every draw.  Instead, the first draw of
+// a frame for a team builds a copy of its spans with the colors
+// already remapped and the team flags cleared, which the blitter can
+// copy straight.  The least recently used copies are dropped once
+// TEAM_SPANS_BUDGET bytes are held.
+// Viewscreens may draw from several threads at once, so lookups take
+// team_spans_lock, and while the cache is held nothing is dropped that
+// another thread could still be copying from.
+
+#define TEAM_SPANS_BUDGET (4*1024*1024)
+
+struct TeamSpans
+{
+    unsigned char* frame;
+    unsigned char teamcolor;
+    unsigned char* spans;  // NULL if the frame has no team colors
+    size_t size;
+};
+
+typedef std::pair<unsigned char*, unsigned char> TeamSpansKey;
+static std::list<TeamSpans> team_spans_lru;  // most recently used first
+static std::map<TeamSpansKey, std::list<TeamSpans>::iterator> team_spans_index;
+static size_t team_spans_bytes = 0;
+static SDL_SpinLock team_spans_lock = 0;
+static int team_spans_held = 0;
+
+// Size in bytes of one frame's spans
+static size_t frame_spans_size(unsigned char* frame, int h)
+{
+    unsigned char* row = frame + ((unsigned int*)frame)[h-1];
+    for(unsigned char count = *row++; count > 0; count--)
+        row += 3 + row[1];
+    return row - frame;
+}
+
+static void drop_team_spans(std::list<TeamSpans>::iterator e)
+{
+    team_spans_index.erase(TeamSpansKey(e->frame, e->teamcolor));
+    team_spans_bytes -= e->size;
+    delete[] e->spans;
+    team_spans_lru.erase(e);
+}
+
+static void trim_team_spans(size_t incoming)
+{
+    while(team_spans_bytes + incoming > TEAM_SPANS_BUDGET && !team_spans_lru.empty())
+        drop_team_spans(--team_spans_lru.end());
+}
+
+// Drops the cached copies made from a span buffer that's going away
+static void forget_team_spans(unsigned char* spans, int frames, int h)
+{
+    if(spans == NULL || frames == 0 || h == 0)
+        return;
+    
+    unsigned char* last = PixieData::frame_spans(spans, frames - 1);
+    unsigned char* end = last + frame_spans_size(last, h);
+    
+    SDL_AtomicLock(&team_spans_lock);
+    std::map<TeamSpansKey, std::list<TeamSpans>::iterator>::iterator e, next;
+    e = team_spans_index.lower_bound(TeamSpansKey(spans, 0));
+    while(e != team_spans_index.end() && e->first.first < end)
+    {
+        next = e;
+        ++next;
+        drop_team_spans(e->second);
+        e = next;
+    }
+    SDL_AtomicUnlock(&team_spans_lock);
+}
+
+unsigned char* PixieData::team_spans(unsigned char* frame, int h, unsigned char teamcolor)
+{
+    if(frame == NULL || h == 0)
+        return frame;
+    
+    SDL_AtomicLock(&team_spans_lock);
+    
+    std::map<TeamSpansKey, std::list<TeamSpans>::iterator>::iterator found;
+    found = team_spans_index.find(TeamSpansKey(frame, teamcolor));
+    if(found != team_spans_index.end())
+    {
+        std::list<TeamSpans>::iterator e = found->second;
+        if(e != team_spans_lru.begin())
+            team_spans_lru.splice(team_spans_lru.begin(), team_spans_lru, e);
+        unsigned char* result = (e->spans ? e->spans : frame);
+        SDL_AtomicUnlock(&team_spans_lock);
+        return result;
+    }
+    
+    TeamSpans entry;
+    entry.frame = frame;
+    entry.teamcolor = teamcolor;
+    entry.spans = NULL;
+    entry.size = 0;
+    
+    size_t size = frame_spans_size(frame, h);
+    for(int y = 0; y < h && entry.spans == NULL; y++)
+    {
+        unsigned char* row = frame + ((unsigned int*)frame)[y];
+        for(unsigned char count = *row++; count > 0; count--)
+        {
+            if(row[2])
+            {
+                entry.spans = new unsigned char[size];
+                entry.size = size;
+                break;
+            }
+            row += 3 + row[1];
+        }
+    }
+    
+    if(entry.spans)
+    {
+        memcpy(entry.spans, frame, size);
+        for(int y = 0; y < h; y++)
+        {
+            unsigned char* row = entry.spans + ((unsigned int*)entry.spans)[y];
+            for(unsigned char count = *row++; count > 0; count--)
+            {
+                unsigned char run = row[1];
+                if(row[2])
+                {
+                    row[2] = 0;
+                    for(int i = 0; i < run; i++)
+                        row[3 + i] = (unsigned char) (teamcolor + (255 - row[3 + i]));
+                }
+                row += 3 + run;
+            }
+        }
+    }
+    
+    if(!team_spans_held)
+        trim_team_spans(entry.size);
+    
+    team_spans_lru.push_front(entry);
+    team_spans_index[TeamSpansKey(frame, teamcolor)] = team_spans_lru.begin();
+    team_spans_bytes += entry.size;
+    
+    SDL_AtomicUnlock(&team_spans_lock);
+    return (entry.spans ? entry.spans : frame);
+}
+
+void PixieData::hold_team_spans()
+{
+    team_spans_held++;
+}
+
+// Catches up on what was kept over budget while held
+void PixieData::release_team_spans()
+{
+    if(--team_spans_held == 0)
+    {
+        SDL_AtomicLock(&team_spans_lock);
+        trim_team_spans(0);
+        SDL_AtomicUnlock(&team_spans_lock);
+    }
+}
+
 void PixieData::clear()
 {
     frames = 0;
     w = 0;
     h = 0;
     data = NULL;
+    spans = NULL;
+    in_arena = false;
 }
 
 void PixieData::free()
 {
+    forget_team_spans(spans, frames, h);
     frames = 0;
     w = 0;
     h = 0;
-    delete[] data;
+    if(!in_arena)
+    {
+        delete[] data;
+        delete[] spans;
+    }
     data = NULL;
+    spans = NULL;
+    in_arena = false;
 }
@@ -18,6 +18,32 @@
 #ifndef _PIXIE_DATA_H__
 #define _PIXIE_DATA_H__
 
+#include <stddef.h>
+#include <vector>
+
+// Sprites that are loaded together (all the tiles, all the walker
+// graphics) get their data and spans from a few large blocks instead of
+// one allocation each.  They sit in the order they were loaded, which is
+// the order they are drawn in, and are freed all at once.
+class PixieArena
+{
+    public:
+    
+    PixieArena();
+    ~PixieArena();
+    
+    unsigned char* alloc(size_t size);
+    void free();
+    
+    private:
+    
+    std::vector<unsigned char*> blocks;
+    size_t block_used;  // bytes handed out from blocks.back()
+    size_t block_size;  // size of blocks.back()
+    
+    PixieArena(const PixieArena&);
+    PixieArena& operator=(const PixieArena&);
+};
 
 class PixieData
 {
@@ -26,12 +52,25 @@ class PixieData
     unsigned char frames;
     unsigned char w, h;
     unsigned char* data;
+    // Opaque spans of every frame, built by compile_spans()
+    unsigned char* spans;
+    // data and spans belong to a PixieArena and are not deleted by free()
+    bool in_arena;
     
     PixieData();
     PixieData(unsigned char frames, unsigned char w, unsigned char h, unsigned char* data);
     
     bool valid() const;
     
+    void compile_spans(bool team_colors = true, PixieArena* arena = NULL);  // false if already recolored; arena holds data too
+    unsigned char* frame_spans(int frame) const;
+    static unsigned char* frame_spans(unsigned char* spans, int frame);
+    // A frame's spans with the team colors already remapped for teamcolor
+    static unsigned char* team_spans(unsigned char* frame, int h, unsigned char teamcolor);
+    // Keep every team_spans() result valid until released (for parallel drawing)
+    static void hold_team_spans();
+    static void release_team_spans();
+    
     void clear();
     void free();
 };
@@ -48,6 +48,7 @@ pixieN::pixieN(const PixieData& data, int doaccel):
 pixieN::~pixieN()
 {
 	bmp = NULL;
+	bmp_spans = NULL;
 	facings = NULL;
 	frames = 0;
 	frame = 0;
@@ -63,6 +64,7 @@ short pixieN::set_frame(short framenum)
 		return 0;
 	}
 	bmp = facings+framenum*size;
+	bmp_spans = PixieData::frame_spans(spans, framenum);
 	frame = framenum;
 	return 1;
 }
@@ -103,22 +103,18 @@ void radar::start(LevelData* data)
             #endif
         #endif
     }
-    if(bmp != NULL)
-        delete[] bmp;
-    bmp = new unsigned char[size];
-	update(data);
+	if (data->radar_map == NULL)
+		data->build_radar_map();
+	bmp = data->radar_map;
 
 }
 
 
 // Destruct the radar and its variables
+// (the map belongs to the level)
 radar::~radar()
 {
-	if (bmp)
-	{
-		delete[] bmp;
-		bmp = NULL;
-	}
+	bmp = NULL;
 }
 
 short radar::draw()
@@ -126,22 +122,40 @@ short radar::draw()
     return draw(&myscreen->level_data);
 }
 
+// Everything draw() would change outside this radar, so that radars
+// of several viewscreens can then draw at the same time
+void radar::prepare(LevelData* data)
+{
+	if (viewscreenp && !viewscreenp->radarstart)
+	{
+		start(data);
+		viewscreenp->radarstart = 1;
+	}
+
+	// The terrain layer is the level's; pick it up again in case the
+	// grid was rebuilt or resized since we last looked
+	if (data->radar_map == NULL)
+		data->build_radar_map();
+	if (sizex != data->grid.w || sizey != data->grid.h)
+		start(data);
+	bmp = data->radar_map;
+}
+
 short radar::draw(LevelData* data)
 {
 	Sint32 tempx, tempy, tempz;
 	unsigned char tempcolor;
 	short oborder, obfamily, obteam;
 	short can_see = 0, do_show = 0;
-	Sint32 listtype = 0;
+	// The viewscreen's dice, as we may be off the main thread.  A radar
+	// of its own is only drawn from the main one.
+	Uint32 own_seed = (viewscreenp ? 0 : (Uint32) rand());
+	Uint32& seed = (viewscreenp ? viewscreenp->draw_seed : own_seed);
 
 	radarx = 0;
 	radary = 0;
 
-	if (viewscreenp && !viewscreenp->radarstart)
-	{
-		start(data);
-		viewscreenp->radarstart = 1;
-	}
+	prepare(data);
 
 	if (viewscreenp && viewscreenp->control)
 	{
@@ -175,164 +189,120 @@ short radar::draw(LevelData* data)
 	                   &bmp[radarx + (radary * sizex)], alpha);
 
 	// Now determine what objects are visible on the radar ..
-	while (listtype <= 1)
+	// Only the ones near our part of the map are worth a look; a blip
+	// lands at (xpos+1)/GRID_SIZE, hence the extra pixel.
+	data->myobmap->query_rect((short) (radarx*GRID_SIZE - 1), (short) (radary*GRID_SIZE - 1),
+	                          (short) (xview*GRID_SIZE + 1), (short) (yview*GRID_SIZE + 1), blips);
+
+	for (size_t i = 0; i < blips.size(); i++)
 	{
-	    std::list<walker*>* ls;
-		if (listtype == 0) // do oblist, standard
-		{
-			ls = &data->oblist;
-			listtype++;
-		}
-		else if (listtype == 1) // do weapons
+		walker* ob = blips[i];
+		if (ob->dead)
+			continue;
+
+		oborder  = ob->query_order();
+		obfamily = ob->query_family();
+		if (!on_screen( (short) ((ob->xpos+1)/GRID_SIZE),
+		                (short) ((ob->ypos+1)/GRID_SIZE),
+		                radarx, radary) )
+			continue;
+
+		tempx = xloc + ((ob->xpos+1)/GRID_SIZE - radarx);
+		tempy = yloc + ((ob->ypos+1)/GRID_SIZE - radary);
+		tempz = (tempx+(tempy*320)); //this may need fixing
+		if (tempz > 64000 || tempz < 0)
 		{
-			ls = &data->weaplist;
-			listtype++;
+			Log("bad radar, bad\n");
+			return 1;
 		}
-		else
-			continue;
 
-        for(auto e = ls->begin(); e != ls->end(); e++)
+		// Treasure other than life gems: exits, gold, potions ..
+		if (oborder == ORDER_TREASURE && obfamily != FAMILY_LIFE_GEM)
 		{
-		    walker* ob = *e;
-		    
-            oborder = ob->query_order();
 			do_show = 0; // don't show, by default
-			if ((oborder == ORDER_LIVING || oborder == ORDER_WEAPON
-			            || (oborder == ORDER_TREASURE && (ob->query_family() == FAMILY_LIFE_GEM))
-			            || (oborder == ORDER_TREASURE && (ob->query_family() == FAMILY_EXIT))
-			            || (oborder == ORDER_GENERATOR && can_see)
-			           )
-			        && (obteam==ob->team_num || ob->invisibility_left < 1 || can_see)
-			        && on_screen( (short) ((ob->xpos+1)/GRID_SIZE), (short) ((ob->ypos+1)/GRID_SIZE), radarx, radary)
-			   )
-				do_show = 1;
-			if (do_show)
+			if (can_see)
 			{
-				tempx = xloc + ((ob->xpos+1)/GRID_SIZE - radarx);
-				tempy = yloc + ((ob->ypos+1)/GRID_SIZE - radary);
-				if ( (tempx < xloc) || (tempx > (xloc + xview)) )
-				{} //do nothing
-				else if ( (tempy < yloc) || (tempy > (yloc + yview)) )
-				{} //also do nothing
-				else
+				switch (obfamily)
 				{
-					tempz = (tempx+(tempy*320)); //this may need fixing
-					if (tempz > 64000 || tempz < 0)
-					{
-						Log("bad radar, bad\n");
-						return 1;
-					}
-					tempcolor = (ob->query_team_color());
-					if (viewscreenp && viewscreenp->control == ob)
-					{
-						tempcolor = (unsigned char) (random(256));
-						if (tempx >= (xloc + xview - 1) && tempy < (yloc+yview) )
-						{
-							myscreen->pointb(tempx-1,tempy,tempcolor, alpha);
-							myscreen->pointb(tempx,tempy,tempcolor, alpha);
-							myscreen->pointb(tempx-1,tempy+1,tempcolor, alpha);
-							myscreen->pointb(tempx,tempy+1,tempcolor, alpha);
-
-						}
-						else if (tempx >= (xloc + xview -1) )
-						{
-							myscreen->pointb(tempx,tempy,tempcolor, alpha);
-							myscreen->pointb(tempx-1,tempy,tempcolor, alpha);
-							myscreen->pointb(tempx,tempy-1,tempcolor, alpha);
-							myscreen->pointb(tempx-1,tempy-1,tempcolor, alpha);
-
-						}
-						else if (tempy >= (yloc + yview -1) && tempx < (xloc+xview) )
-						{
-							myscreen->pointb(tempx,tempy,tempcolor, alpha);
-							myscreen->pointb(tempx+1,tempy,tempcolor, alpha);
-							myscreen->pointb(tempx,tempy-1,tempcolor, alpha);
-							myscreen->pointb(tempx+1,tempy-1,tempcolor, alpha);
-						}
-						else
-						{
-							myscreen->pointb(tempx,tempy,tempcolor, alpha);
-							myscreen->pointb(tempx+1,tempy,tempcolor, alpha);
-							myscreen->pointb(tempx,tempy+1,tempcolor, alpha);
-							myscreen->pointb(tempx+1,tempy+1,tempcolor, alpha);
-						}
-					}
-					else if (oborder == ORDER_LIVING)
-						myscreen->pointb(tempx,tempy,tempcolor, alpha);
-					else if (oborder == ORDER_GENERATOR)
-						myscreen->pointb(tempx,tempy,(char)(tempcolor+1), alpha);
-					else if (oborder == ORDER_TREASURE) // currently life gems
-						myscreen->pointb(tempx,tempy,COLOR_FIRE, alpha);
-					else
-						myscreen->pointb(tempx,tempy,COLOR_WHITE, alpha);
-				}//draw the blob onto the radar
+					case FAMILY_GOLD_BAR:
+						do_show = (short) (YELLOW + random_from(seed, 5));
+						break;
+					case FAMILY_SILVER_BAR:
+						do_show = (short) (GREY + random_from(seed, 5));
+						break;
+					case FAMILY_DRUMSTICK:
+						do_show = (short) (COLOR_BROWN + random_from(seed, 2));
+						break;
+					case FAMILY_MAGIC_POTION:
+					case FAMILY_INVIS_POTION:
+					case FAMILY_INVULNERABLE_POTION:
+					case FAMILY_FLIGHT_POTION:
+						do_show = (short) (COLOR_BLUE + random_from(seed, 5));
+						break;
+					default:
+						do_show = 0;
+						break;
+				}
 			}
+			if (obfamily == FAMILY_EXIT || obfamily == FAMILY_TELEPORTER)
+				do_show = (short) LIGHT_BLUE + random_from(seed, 7);
+			if (do_show)
+				myscreen->pointb(tempx,tempy,(char)do_show, alpha);
+			continue;
 		}
-	} // go back to new screen lists (weapons, etc.)
 
-    for(auto e = data->fxlist.begin(); e != data->fxlist.end(); e++)
-	{
-	    walker* ob = *e;
-		if (ob && !ob->dead)
+		if ((oborder == ORDER_LIVING || oborder == ORDER_WEAPON
+		            || oborder == ORDER_TREASURE // life gems
+		            || (oborder == ORDER_GENERATOR && can_see)
+		           )
+		        && (obteam==ob->team_num || ob->invisibility_left < 1 || can_see)
+		   )
 		{
-			oborder  = ob->query_order();
-			obfamily = ob->query_family();
-
-			do_show = 0; // don't show, by default
-			if (oborder == ORDER_TREASURE)
+			tempcolor = (ob->query_team_color());
+			if (viewscreenp && viewscreenp->control == ob)
 			{
-				if (can_see)
+				tempcolor = (unsigned char) (random_from(seed, 256));
+				if (tempx >= (xloc + xview - 1) && tempy < (yloc+yview) )
+				{
+					myscreen->pointb(tempx-1,tempy,tempcolor, alpha);
+					myscreen->pointb(tempx,tempy,tempcolor, alpha);
+					myscreen->pointb(tempx-1,tempy+1,tempcolor, alpha);
+					myscreen->pointb(tempx,tempy+1,tempcolor, alpha);
+
+				}
+				else if (tempx >= (xloc + xview -1) )
 				{
-					switch (obfamily)
-					{
-						case FAMILY_GOLD_BAR:
-							do_show = (short) (YELLOW + random(5));
-							break;
-						case FAMILY_SILVER_BAR:
-							do_show = (short) (GREY + random(5));
-							break;
-						case FAMILY_DRUMSTICK:
-							do_show = (short) (COLOR_BROWN + random(2));
-							break;
-						case FAMILY_MAGIC_POTION:
-						case FAMILY_INVIS_POTION:
-						case FAMILY_INVULNERABLE_POTION:
-						case FAMILY_FLIGHT_POTION:
-							do_show = (short) (COLOR_BLUE + random(5));
-							break;
-						default:
-							do_show = 0;
-							break;
-					}
+					myscreen->pointb(tempx,tempy,tempcolor, alpha);
+					myscreen->pointb(tempx-1,tempy,tempcolor, alpha);
+					myscreen->pointb(tempx,tempy-1,tempcolor, alpha);
+					myscreen->pointb(tempx-1,tempy-1,tempcolor, alpha);
+
+				}
+				else if (tempy >= (yloc + yview -1) && tempx < (xloc+xview) )
+				{
+					myscreen->pointb(tempx,tempy,tempcolor, alpha);
+					myscreen->pointb(tempx+1,tempy,tempcolor, alpha);
+					myscreen->pointb(tempx,tempy-1,tempcolor, alpha);
+					myscreen->pointb(tempx+1,tempy-1,tempcolor, alpha);
 				}
-				if (obfamily == FAMILY_EXIT || obfamily == FAMILY_TELEPORTER)
-					do_show = (short) LIGHT_BLUE + random(7);
-			}
-			if (!on_screen( (short) ((ob->xpos+1)/GRID_SIZE),
-			                (short) ((ob->ypos+1)/GRID_SIZE),
-			                radarx, radary) )
-				do_show = 0;
-			if (do_show)
-			{
-				tempx = xloc + ((ob->xpos+1)/GRID_SIZE - radarx);
-				tempy = yloc + ((ob->ypos+1)/GRID_SIZE - radary);
-				if ( (tempx < xloc) || (tempx > (xloc + xview)) )
-				{} //do nothing
-				else if ( (tempy < yloc) || (tempy > (yloc + yview)) )
-				{} //also do nothing
 				else
 				{
-					tempz = (tempx+(tempy*320)); //this may need fixing
-					if (tempz > 64000 || tempz < 0)
-					{
-						Log("bad radar, bad\n");
-						return 1;
-					}
-					myscreen->pointb(tempx,tempy,(char)do_show, alpha);
-				}//draw the blob onto the radar
-			} // end of valid do_show
-		}  // end of if here->ob
-	} // end of while (here)
+					myscreen->pointb(tempx,tempy,tempcolor, alpha);
+					myscreen->pointb(tempx+1,tempy,tempcolor, alpha);
+					myscreen->pointb(tempx,tempy+1,tempcolor, alpha);
+					myscreen->pointb(tempx+1,tempy+1,tempcolor, alpha);
+				}
+			}
+			else if (oborder == ORDER_LIVING)
+				myscreen->pointb(tempx,tempy,tempcolor, alpha);
+			else if (oborder == ORDER_GENERATOR)
+				myscreen->pointb(tempx,tempy,(char)(tempcolor+1), alpha);
+			else if (oborder == ORDER_TREASURE) // currently life gems
+				myscreen->pointb(tempx,tempy,COLOR_FIRE, alpha);
+			else
+				myscreen->pointb(tempx,tempy,COLOR_WHITE, alpha);
+		}//draw the blob onto the radar
+	}
 
 	return 1;
 }
@@ -368,185 +338,187 @@ void radar::update()
     update(&myscreen->level_data);
 }
 
-// This function re-initializes the radar map data.  Do not
-// call it often, as it is very slow ..
+// Shares the level's radar map, which is built and patched along
+// with its background.  This rebuilds it, which is slow: don't call it
+// for single tiles, LevelData::update_background does those.
 void radar::update(LevelData* data)
 {
-	short temp, i, j;
+	data->build_radar_map();
+	bmp = data->radar_map;
+}
 
-	for (i = 0; i < sizex; i++)
-		for (j = 0; j < sizey; j++)
-		{
-			// Check if item in background grid
-			switch ((unsigned char)data->grid.data[i+sizex*j])
-			{
-				case PIX_GRASS1:  // grass is green
-				case PIX_GRASS_DARK_1:
-				case PIX_GRASS_DARK_B1:
-				case PIX_GRASS_DARK_BR:
-					temp = COLOR_GREEN+3;
-					break;
-				case PIX_GRASS2:
-				case PIX_GRASS_DARK_2:
-				case PIX_GRASS_DARK_B2:
-				case PIX_WALL_ARROW_GRASS:
-					temp = COLOR_GREEN+4;
-					break;
-				case PIX_GRASS3:
-				case PIX_GRASS_DARK_3:
-				case PIX_GRASS_DARK_R1:
-				case PIX_WALL_ARROW_GRASS_DARK:
-					temp = COLOR_GREEN+5;
-					break;
-				case PIX_GRASS4:
-				case PIX_GRASS_DARK_4:
-				case PIX_GRASS_DARK_R2:
-					temp = COLOR_GREEN+5;
-					break;
-				case PIX_GRASS_DARK_LL:
-				case PIX_GRASS_DARK_UR:
-				case PIX_GRASS_RUBBLE:
-				case PIX_GRASS_LIGHT_1: // lighter grass
-				case PIX_GRASS_LIGHT_TOP:
-				case PIX_GRASS_LIGHT_RIGHT_TOP:
-				case PIX_GRASS_LIGHT_RIGHT:
-				case PIX_GRASS_LIGHT_RIGHT_BOTTOM:
-				case PIX_GRASS_LIGHT_BOTTOM:
-				case PIX_GRASS_LIGHT_LEFT_BOTTOM:
-				case PIX_GRASS_LIGHT_LEFT:
-				case PIX_GRASS_LIGHT_LEFT_TOP:
-					temp = (short) (COLOR_GREEN + random(3) + 3);
-					break;
-				case PIX_TREE_M1: // Trees are green
-				case PIX_TREE_ML:
-				case PIX_TREE_T1:
-				case PIX_TREE_MR:
-				case PIX_TREE_MT:
-					temp = (short) (COLOR_TREES + random(3));
-					break;
-				case PIX_TREE_B1: // Trunks are brown
-					temp = COLOR_BROWN + 6;
-					break;
-				case PIX_PAVEMENT1:   // pavement dark grey
-				case PIX_PAVEMENT2:
-				case PIX_PAVEMENT3:
-				case PIX_PAVESTEPS1:
-				case PIX_PAVESTEPS2:
-				case PIX_PAVESTEPS2L:
-				case PIX_PAVESTEPS2R:
-				case PIX_COBBLE_1:
-				case PIX_COBBLE_2:
-				case PIX_COBBLE_3:
-				case PIX_COBBLE_4:
-					temp = 17;
-					break;
-				case PIX_FLOOR_PAVEL: // wood is brown
-				case PIX_FLOOR_PAVER:
-				case PIX_FLOOR_PAVEU:
-				case PIX_FLOOR_PAVED:
-				case PIX_FLOOR1:
-				case PIX_WALL_ARROW_FLOOR:
-					temp = COLOR_BROWN+4;
-					break;
-				case PIX_DIRT_1: // path is brown
-				case PIX_DIRTGRASS_UL1:
-				case PIX_DIRTGRASS_UR1:
-				case PIX_DIRTGRASS_LL1:
-				case PIX_DIRTGRASS_LR1:
-				case PIX_DIRT_DARK_1:
-				case PIX_DIRTGRASS_DARK_UL1:
-				case PIX_DIRTGRASS_DARK_UR1:
-				case PIX_DIRTGRASS_DARK_LL1:
-				case PIX_DIRTGRASS_DARK_LR1:
-					temp = COLOR_BROWN+5;
-					break;
-				case PIX_JAGGED_GROUND_1:
-				case PIX_JAGGED_GROUND_2:
-				case PIX_JAGGED_GROUND_3:
-				case PIX_JAGGED_GROUND_4:
-					temp = COLOR_BROWN+5;
-					break;
-				case PIX_CLIFF_BOTTOM:  // slightly darker
-				case PIX_CLIFF_TOP:
-				case PIX_CLIFF_LEFT:
-				case PIX_CLIFF_RIGHT:
-				case PIX_CLIFF_BACK_1:
-				case PIX_CLIFF_BACK_2:
-				case PIX_CLIFF_BACK_L:
-				case PIX_CLIFF_BACK_R:
-				case PIX_CLIFF_TOP_L:
-				case PIX_CLIFF_TOP_R:
-					temp = COLOR_BROWN+6;
-					break;
-				case PIX_CARPET_LL:   // carpet is purple
-				case PIX_CARPET_B:
-				case PIX_CARPET_LR:
-				case PIX_CARPET_UR:
-				case PIX_CARPET_U:
-				case PIX_CARPET_UL:
-				case PIX_CARPET_L:
-				case PIX_CARPET_M:
-				case PIX_CARPET_M2:
-				case PIX_CARPET_R:
-				case PIX_CARPET_SMALL_HOR:
-                case PIX_CARPET_SMALL_VER:
-				case PIX_CARPET_SMALL_CUP:
-				case PIX_CARPET_SMALL_CAP:
-				case PIX_CARPET_SMALL_LEFT:
-				case PIX_CARPET_SMALL_RIGHT:
-				case PIX_CARPET_SMALL_TINY:
-					temp = COLOR_PURPLE+4;
-					break;
-				case PIX_H_WALL1: // walls are light grey
-				case PIX_WALL2:
-				case PIX_WALL3:
-				case PIX_WALL_LL:
-				case PIX_WALLTOP_H:
-				case PIX_WALL4:
-				case PIX_WALL5:
-				case PIX_BOULDER_1:
-				case PIX_BOULDER_2:
-				case PIX_BOULDER_3:
-				case PIX_BOULDER_4:
-				case PIX_PATH_1:      // sparser cobblestone/grass
-				case PIX_PATH_2:
-				case PIX_PATH_3:
-				case PIX_PATH_4:
-					temp = 24;
-					break;
-				case PIX_WATER1:      // Water is dark blue
-				case PIX_WATER2:
-				case PIX_WATER3:
-				case PIX_WATERGRASS_LL:
-				case PIX_WATERGRASS_LR:
-				case PIX_WATERGRASS_UL:
-				case PIX_WATERGRASS_UR:
-				case PIX_GRASSWATER_LL:
-				case PIX_GRASSWATER_LR:
-				case PIX_GRASSWATER_UL:
-				case PIX_GRASSWATER_UR:
-					temp = COLOR_BLUE+2;
-					break;
-
-				case PIX_WALLSIDE_L:  // White, maybe?
-				case PIX_WALLSIDE1:
-				case PIX_WALLSIDE_R:
-				case PIX_WALLSIDE_C:
-				case PIX_WALLSIDE_CRACK_C1:
-					temp = COLOR_WHITE-1;
-					break;
-
-				case PIX_TORCH1:
-				case PIX_TORCH2:
-				case PIX_TORCH3:
-				case PIX_BRAZIER1:
-					temp = COLOR_FIRE;
-					break;
-
-				default:
-					temp =  0;
-			}
-			bmp[i+sizex*j] = (unsigned char) temp;
-		}
+// The color a background tile shows up as on the radar
+unsigned char radar_terrain_color(unsigned char tile)
+{
+	short temp;
 
+	switch (tile)
+	{
+		case PIX_GRASS1:  // grass is green
+		case PIX_GRASS_DARK_1:
+		case PIX_GRASS_DARK_B1:
+		case PIX_GRASS_DARK_BR:
+			temp = COLOR_GREEN+3;
+			break;
+		case PIX_GRASS2:
+		case PIX_GRASS_DARK_2:
+		case PIX_GRASS_DARK_B2:
+		case PIX_WALL_ARROW_GRASS:
+			temp = COLOR_GREEN+4;
+			break;
+		case PIX_GRASS3:
+		case PIX_GRASS_DARK_3:
+		case PIX_GRASS_DARK_R1:
+		case PIX_WALL_ARROW_GRASS_DARK:
+			temp = COLOR_GREEN+5;
+			break;
+		case PIX_GRASS4:
+		case PIX_GRASS_DARK_4:
+		case PIX_GRASS_DARK_R2:
+			temp = COLOR_GREEN+5;
+			break;
+		case PIX_GRASS_DARK_LL:
+		case PIX_GRASS_DARK_UR:
+		case PIX_GRASS_RUBBLE:
+		case PIX_GRASS_LIGHT_1: // lighter grass
+		case PIX_GRASS_LIGHT_TOP:
+		case PIX_GRASS_LIGHT_RIGHT_TOP:
+		case PIX_GRASS_LIGHT_RIGHT:
+		case PIX_GRASS_LIGHT_RIGHT_BOTTOM:
+		case PIX_GRASS_LIGHT_BOTTOM:
+		case PIX_GRASS_LIGHT_LEFT_BOTTOM:
+		case PIX_GRASS_LIGHT_LEFT:
+		case PIX_GRASS_LIGHT_LEFT_TOP:
+			temp = (short) (COLOR_GREEN + random(3) + 3);
+			break;
+		case PIX_TREE_M1: // Trees are green
+		case PIX_TREE_ML:
+		case PIX_TREE_T1:
+		case PIX_TREE_MR:
+		case PIX_TREE_MT:
+			temp = (short) (COLOR_TREES + random(3));
+			break;
+		case PIX_TREE_B1: // Trunks are brown
+			temp = COLOR_BROWN + 6;
+			break;
+		case PIX_PAVEMENT1:   // pavement dark grey
+		case PIX_PAVEMENT2:
+		case PIX_PAVEMENT3:
+		case PIX_PAVESTEPS1:
+		case PIX_PAVESTEPS2:
+		case PIX_PAVESTEPS2L:
+		case PIX_PAVESTEPS2R:
+		case PIX_COBBLE_1:
+		case PIX_COBBLE_2:
+		case PIX_COBBLE_3:
+		case PIX_COBBLE_4:
+			temp = 17;
+			break;
+		case PIX_FLOOR_PAVEL: // wood is brown
+		case PIX_FLOOR_PAVER:
+		case PIX_FLOOR_PAVEU:
+		case PIX_FLOOR_PAVED:
+		case PIX_FLOOR1:
+		case PIX_WALL_ARROW_FLOOR:
+			temp = COLOR_BROWN+4;
+			break;
+		case PIX_DIRT_1: // path is brown
+		case PIX_DIRTGRASS_UL1:
+		case PIX_DIRTGRASS_UR1:
+		case PIX_DIRTGRASS_LL1:
+		case PIX_DIRTGRASS_LR1:
+		case PIX_DIRT_DARK_1:
+		case PIX_DIRTGRASS_DARK_UL1:
+		case PIX_DIRTGRASS_DARK_UR1:
+		case PIX_DIRTGRASS_DARK_LL1:
+		case PIX_DIRTGRASS_DARK_LR1:
+			temp = COLOR_BROWN+5;
+			break;
+		case PIX_JAGGED_GROUND_1:
+		case PIX_JAGGED_GROUND_2:
+		case PIX_JAGGED_GROUND_3:
+		case PIX_JAGGED_GROUND_4:
+			temp = COLOR_BROWN+5;
+			break;
+		case PIX_CLIFF_BOTTOM:  // slightly darker
+		case PIX_CLIFF_TOP:
+		case PIX_CLIFF_LEFT:
+		case PIX_CLIFF_RIGHT:
+		case PIX_CLIFF_BACK_1:
+		case PIX_CLIFF_BACK_2:
+		case PIX_CLIFF_BACK_L:
+		case PIX_CLIFF_BACK_R:
+		case PIX_CLIFF_TOP_L:
+		case PIX_CLIFF_TOP_R:
+			temp = COLOR_BROWN+6;
+			break;
+		case PIX_CARPET_LL:   // carpet is purple
+		case PIX_CARPET_B:
+		case PIX_CARPET_LR:
+		case PIX_CARPET_UR:
+		case PIX_CARPET_U:
+		case PIX_CARPET_UL:
+		case PIX_CARPET_L:
+		case PIX_CARPET_M:
+		case PIX_CARPET_M2:
+		case PIX_CARPET_R:
+		case PIX_CARPET_SMALL_HOR:
+        case PIX_CARPET_SMALL_VER:
+		case PIX_CARPET_SMALL_CUP:
+		case PIX_CARPET_SMALL_CAP:
+		case PIX_CARPET_SMALL_LEFT:
+		case PIX_CARPET_SMALL_RIGHT:
+		case PIX_CARPET_SMALL_TINY:
+			temp = COLOR_PURPLE+4;
+			break;
+		case PIX_H_WALL1: // walls are light grey
+		case PIX_WALL2:
+		case PIX_WALL3:
+		case PIX_WALL_LL:
+		case PIX_WALLTOP_H:
+		case PIX_WALL4:
+		case PIX_WALL5:
+		case PIX_BOULDER_1:
+		case PIX_BOULDER_2:
+		case PIX_BOULDER_3:
+		case PIX_BOULDER_4:
+		case PIX_PATH_1:      // sparser cobblestone/grass
+		case PIX_PATH_2:
+		case PIX_PATH_3:
+		case PIX_PATH_4:
+			temp = 24;
+			break;
+		case PIX_WATER1:      // Water is dark blue
+		case PIX_WATER2:
+		case PIX_WATER3:
+		case PIX_WATERGRASS_LL:
+		case PIX_WATERGRASS_LR:
+		case PIX_WATERGRASS_UL:
+		case PIX_WATERGRASS_UR:
+		case PIX_GRASSWATER_LL:
+		case PIX_GRASSWATER_LR:
+		case PIX_GRASSWATER_UL:
+		case PIX_GRASSWATER_UR:
+			temp = COLOR_BLUE+2;
+			break;
+
+		case PIX_WALLSIDE_L:  // White, maybe?
+		case PIX_WALLSIDE1:
+		case PIX_WALLSIDE_R:
+		case PIX_WALLSIDE_C:
+		case PIX_WALLSIDE_CRACK_C1:
+			temp = COLOR_WHITE-1;
+			break;
+
+		case PIX_TORCH1:
+		case PIX_TORCH2:
+		case PIX_TORCH3:
+		case PIX_BRAZIER1:
+			temp = COLOR_FIRE;
+			break;
+
+		default:
+			temp =  0;
+	}
+	return (unsigned char) temp;
 }
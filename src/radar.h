@@ -21,6 +21,7 @@
 
 #include "base.h"
 #include "level_data.h"
+#include <vector>
 
 class radar
 {
@@ -29,6 +30,7 @@ class radar
 		~radar();
 		short draw();
 		short draw(LevelData* data);
+		void prepare(LevelData* data);
 		short sizex, sizey;
 		short xpos,ypos;
 		short xloc, yloc;        // where on the screen to display
@@ -52,7 +54,10 @@ class radar
 		short mynum; // what is my viewscreen-related number?
 		//         char  *buffer;
 		unsigned short size;
+		std::vector<walker*> blips; // what's near the radar, from obmap::query_rect
 };
 
+unsigned char radar_terrain_color(unsigned char tile);
+
 #endif
 
@@ -254,7 +254,7 @@ void show_guy(Sint32 frames, guy* myguy, short centerx, short centery) // shows
 	for (i=0; i <= (frames/4)%4; i++)
 		mywalker->animate();
     
-	mywalker->team_num = myguy->teamnum;
+	mywalker->set_team(myguy->teamnum);
     
     viewscreen* view_buf = myscreen->viewob[0];
 	mywalker->setxy(centerx - (mywalker->sizex/2) + view_buf->topx - view_buf->xloc, centery - (mywalker->sizey/2) + view_buf->topy - view_buf->yloc);
@@ -2,6 +2,7 @@
 #include "sai2x.h"
 #include "util.h"
 #include "input.h"
+#include "pal32.h"
 //#include "os_depend.h"
 
 // Private var for SAI2x
@@ -17,6 +18,8 @@ static int xsai_depth = 0;
 static unsigned char *src_line[4];
 static unsigned char *dst_line[2];
 
+static void choose_scale_kernels();
+
 #define GET_RESULT(A, B, C, D) ((A != C || A != D) - (B != C || B != D))
 
 #define INTERPOLATE(A, B) (((A & colorMask) >> 1) + ((B & colorMask) >> 1) + (A & B & lowPixelMask))
@@ -43,6 +46,7 @@ int Init_2xSaI()
 	qcolorMask=0xFCFCFC;
 	qlowpixelMask=0x30303;
 	xsai_depth = 32;
+	choose_scale_kernels();
 	return 0;
 }
 
@@ -98,7 +102,7 @@ void Super2xSaI_ex2(
 			int nextl1, nextl2;
 			int prevl1;
 
-			if (x==0)
+			if (x + srcx == 0)
 				sub1=0;
 			else
 				sub1=0;
@@ -111,7 +115,9 @@ void Super2xSaI_ex2(
 				add1 = 0;
 			else add1 = 1;
 
-			if (y == 0)
+			// Only the top of the surface has no row above it, so a
+			// band starting further down still blends with its neighbor
+			if (y + srcy == 0)
 				prevl1 = 0;
 			else
 				prevl1 = src_pitch;
@@ -296,7 +302,7 @@ void Scale_SuperEagle(
 			int nextl1, nextl2;
 			int prevl1;
 
-			if (x == 0)
+			if (x + srcx == 0)
 				sub1 = 0;
 			else
 				sub1 = 1;
@@ -309,7 +315,7 @@ void Scale_SuperEagle(
 				add1 = 0;
 			else add1 = 1;
 
-			if (y == 0)
+			if (y + srcy == 0)
 				prevl1 = 0;
 			else
 				prevl1 = src_pitch;
@@ -484,6 +490,615 @@ void Scale_SuperEagle(
 }
 
 
+// Vector versions of the two kernels above.  GCC's vector extensions
+// let one template be compiled for both SSE2 (4 pixels at a time) and
+// AVX2 (8 pixels); Init_2xSaI picks one from what the CPU supports.
+// Each run of pixels is computed branch-free with masks, and the
+// columns too close to the edges are left to the scalar kernels.
+typedef void (*ScaleFunc)(unsigned char* src, int srcx, int srcy, int srcw, int srch,
+                          int src_pitch, int src_height,
+                          unsigned char* dst, int dstx, int dsty, int dst_pitch);
+
+static ScaleFunc sai_func = Super2xSaI_ex2;
+static ScaleFunc eagle_func = Scale_SuperEagle;
+
+#if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+#define SAI_SIMD
+
+// The helpers pass vectors by value, but they are always inlined into
+// the kernels below, so the AVX calling convention never matters.
+// (Not popped: GCC reports these when the file ends.)
+#pragma GCC diagnostic ignored "-Wpsabi"
+
+typedef Uint32 sai_v4 __attribute__((vector_size(16)));
+typedef Uint32 sai_v8 __attribute__((vector_size(32)));
+
+#define SAI_INLINE inline __attribute__((always_inline))
+#define V_EQ(A, B) ((V)((A) == (B)))
+#define V_NE(A, B) ((V)((A) != (B)))
+
+template <typename V>
+static SAI_INLINE V v_load(const Uint32* p)
+{
+	V v;
+	memcpy(&v, p, sizeof(V));
+	return v;
+}
+
+template <typename V>
+static SAI_INLINE V v_splat(Uint32 c)
+{
+	V v = {};
+	return v + c;
+}
+
+template <typename V>
+static SAI_INLINE V v_select(const V& mask, const V& a, const V& b)
+{
+	return (mask & a) | (~mask & b);
+}
+
+// Stores the 2x2 products of each pixel as two interleaved rows
+template <typename V>
+static SAI_INLINE void v_store2x2(Uint32* d0, Uint32* d1, const V& product1a, const V& product1b, const V& product2a, const V& product2b)
+{
+	for (unsigned int i = 0; i < sizeof(V)/sizeof(Uint32); i++)
+	{
+		d0[2*i] = product1a[i];
+		d0[2*i+1] = product1b[i];
+		d1[2*i] = product2a[i];
+		d1[2*i+1] = product2b[i];
+	}
+}
+
+template <typename V>
+struct SaiBlend
+{
+	V color, low, qcolor, qlow;
+
+	SAI_INLINE SaiBlend()
+		: color(v_splat<V>(colorMask)), low(v_splat<V>(lowPixelMask)),
+		  qcolor(v_splat<V>(qcolorMask)), qlow(v_splat<V>(qlowpixelMask))
+	{}
+
+	SAI_INLINE V interpolate(const V& A, const V& B) const
+	{
+		return ((A & color) >> 1) + ((B & color) >> 1) + (A & B & low);
+	}
+
+	SAI_INLINE V q_interpolate(const V& A, const V& B, const V& C, const V& D) const
+	{
+		return ((A & qcolor) >> 2) + ((B & qcolor) >> 2) + ((C & qcolor) >> 2) + ((D & qcolor) >> 2)
+		       + ((((A & qlow) + (B & qlow) + (C & qlow) + (D & qlow)) >> 2) & qlow);
+	}
+
+	// GET_RESULT for all lanes: -1, 0 or 1 in two's complement
+	SAI_INLINE V result(const V& A, const V& B, const V& C, const V& D) const
+	{
+		return ((V_NE(B, C) | V_NE(B, D)) - (V_NE(A, C) | V_NE(A, D)));
+	}
+};
+
+// Super2xSaI of one run of pixels.  The row pointers are already at the
+// first pixel; like the scalar kernel, it never looks to the left.
+template <typename V>
+static SAI_INLINE void sai_block(const SaiBlend<V>& blend,
+                                 const Uint32* rowB, const Uint32* row5, const Uint32* row2, const Uint32* rowA,
+                                 Uint32* d0, Uint32* d1)
+{
+	V colorB1 = v_load<V>(rowB), colorB2 = v_load<V>(rowB + 1), colorB3 = v_load<V>(rowB + 2);
+	V color5 = v_load<V>(row5), color6 = v_load<V>(row5 + 1), colorS2 = v_load<V>(row5 + 2);
+	V color2 = v_load<V>(row2), color3 = v_load<V>(row2 + 1), colorS1 = v_load<V>(row2 + 2);
+	V colorA1 = v_load<V>(rowA), colorA2 = v_load<V>(rowA + 1), colorA3 = v_load<V>(rowA + 2);
+	V colorB0 = colorB1, color4 = color5, color1 = color2, colorA0 = colorA1;
+
+	V e26 = V_EQ(color2, color6);
+	V e53 = V_EQ(color5, color3);
+
+	V r = v_splat<V>(4) + blend.result(color6, color5, color1, colorA1)
+	                    + blend.result(color6, color5, color4, colorB1)
+	                    + blend.result(color6, color5, colorA2, colorS1)
+	                    + blend.result(color6, color5, colorB2, colorS2);
+	V tie = v_select<V>((V)(r > v_splat<V>(4)), color6,
+	                    v_select<V>((V)(r < v_splat<V>(4)), color5, blend.interpolate(color5, color6)));
+	V same = v_select<V>(e26 & ~e53, color2, v_select<V>(e53 & ~e26, color5, tie));
+
+	V product2b = v_select<V>(V_EQ(color6, color3) & V_EQ(color3, colorA1) & V_NE(color2, colorA2) & V_NE(color3, colorA0),
+	                          blend.q_interpolate(color3, color3, color3, color2),
+	              v_select<V>(V_EQ(color5, color2) & V_EQ(color2, colorA2) & V_NE(colorA1, color3) & V_NE(color2, colorA3),
+	                          blend.q_interpolate(color2, color2, color2, color3),
+	                          blend.interpolate(color2, color3)));
+	V product1b = v_select<V>(V_EQ(color6, color3) & V_EQ(color6, colorB1) & V_NE(color5, colorB2) & V_NE(color6, colorB0),
+	                          blend.q_interpolate(color6, color6, color6, color5),
+	              v_select<V>(V_EQ(color5, color2) & V_EQ(color5, colorB2) & V_NE(colorB1, color6) & V_NE(color5, colorB3),
+	                          blend.q_interpolate(color6, color5, color5, color5),
+	                          blend.interpolate(color5, color6)));
+	product2b = v_select<V>(e26 | e53, same, product2b);
+	product1b = v_select<V>(e26 | e53, same, product1b);
+
+	V product2a = v_select<V>((V_EQ(color5, color3) & V_NE(color2, color6) & V_EQ(color4, color5) & V_NE(color5, colorA2))
+	                          | (V_EQ(color5, color1) & V_EQ(color6, color5) & V_NE(color4, color2) & V_NE(color5, colorA0)),
+	                          blend.interpolate(color2, color5), color2);
+	V product1a = v_select<V>((V_EQ(color2, color6) & V_NE(color5, color3) & V_EQ(color1, color2) & V_NE(color2, colorB2))
+	                          | (V_EQ(color4, color2) & V_EQ(color3, color2) & V_NE(color1, color5) & V_NE(color2, colorB0)),
+	                          blend.interpolate(color2, color5), color5);
+
+	v_store2x2<V>(d0, d1, product1a, product1b, product2a, product2b);
+}
+
+// SuperEagle of one run of pixels, none of them in the first column
+template <typename V>
+static SAI_INLINE void eagle_block(const SaiBlend<V>& blend,
+                                   const Uint32* rowB, const Uint32* row5, const Uint32* row2, const Uint32* rowA,
+                                   Uint32* d0, Uint32* d1)
+{
+	V colorB1 = v_load<V>(rowB), colorB2 = v_load<V>(rowB + 1);
+	V color4 = v_load<V>(row5 - 1), color5 = v_load<V>(row5), color6 = v_load<V>(row5 + 1), colorS2 = v_load<V>(row5 + 2);
+	V color1 = v_load<V>(row2 - 1), color2 = v_load<V>(row2), color3 = v_load<V>(row2 + 1), colorS1 = v_load<V>(row2 + 2);
+	V colorA1 = v_load<V>(rowA), colorA2 = v_load<V>(rowA + 1);
+
+	V e26 = V_EQ(color2, color6);
+	V e53 = V_EQ(color5, color3);
+	V i56 = blend.interpolate(color5, color6);
+	V i23 = blend.interpolate(color2, color3);
+
+	// Neither diagonal matches
+	V i26 = blend.interpolate(color2, color6);
+	V i53 = blend.interpolate(color5, color3);
+	V product1a = blend.q_interpolate(color5, color5, color5, i26);
+	V product2b = blend.q_interpolate(color3, color3, color3, i26);
+	V product1b = blend.q_interpolate(color6, color6, color6, i53);
+	V product2a = blend.q_interpolate(color2, color2, color2, i53);
+
+	// Both diagonals match
+	V r = v_splat<V>(4) + blend.result(color6, color5, color1, colorA1)
+	                    + blend.result(color6, color5, color4, colorB1)
+	                    + blend.result(color6, color5, colorA2, colorS1)
+	                    + blend.result(color6, color5, colorB2, colorS2);
+	V pos = (V)(r > v_splat<V>(4));
+	V neg = (V)(r < v_splat<V>(4));
+	V both = e26 & e53;
+	product1a = v_select<V>(both, v_select<V>(pos, i56, color5), product1a);
+	product2b = v_select<V>(both, v_select<V>(pos, i56, color5), product2b);
+	product1b = v_select<V>(both, v_select<V>(pos, color2, v_select<V>(neg, i56, color2)), product1b);
+	product2a = v_select<V>(both, v_select<V>(pos, color2, v_select<V>(neg, i56, color2)), product2a);
+
+	// Only 5-3 matches
+	V only53 = e53 & ~e26;
+	product1a = v_select<V>(only53, color5, product1a);
+	product2b = v_select<V>(only53, color5, product2b);
+	product1b = v_select<V>(only53, v_select<V>(V_EQ(colorB1, color5) | V_EQ(color3, colorS1),
+	                                            blend.interpolate(color5, i56), i56), product1b);
+	product2a = v_select<V>(only53, v_select<V>(V_EQ(color3, colorA2) | V_EQ(color4, color5),
+	                                            blend.interpolate(color5, blend.interpolate(color5, color2)), i23), product2a);
+
+	// Only 2-6 matches
+	V only26 = e26 & ~e53;
+	product1b = v_select<V>(only26, color2, product1b);
+	product2a = v_select<V>(only26, color2, product2a);
+	product1a = v_select<V>(only26, v_select<V>(V_EQ(color1, color2) | V_EQ(color6, colorB2),
+	                                            blend.interpolate(color2, blend.interpolate(color2, color5)), i56), product1a);
+	product2b = v_select<V>(only26, v_select<V>(V_EQ(color6, colorS2) | V_EQ(color2, colorA1),
+	                                            blend.interpolate(color2, i23), i23), product2b);
+
+	v_store2x2<V>(d0, d1, product1a, product1b, product2a, product2b);
+}
+
+// Same arguments and output as the scalar kernels
+template <typename V, bool eagle>
+static SAI_INLINE void scale_simd(
+	unsigned char* src,
+	int srcx, int srcy,
+	int srcw, int srch,
+	int src_pitch,
+	int src_height,
+	unsigned char* dst,
+	int dstx,
+	int dsty,
+	int dst_pitch )
+{
+	const int lanes = sizeof(V)/sizeof(Uint32);
+	ScaleFunc scalar = eagle ? Scale_SuperEagle : Super2xSaI_ex2;
+	SaiBlend<V> blend;
+	int width = src_pitch/4;
+
+	if (srcx + srcw >= width)
+		srcw = width - srcx;
+
+	// The vector runs need 2 pixels to their right (and 1 to the left
+	// for eagle); the columns outside that go to the scalar kernel
+	int first = srcx, last = srcx + srcw;
+	int vstart = (eagle && first == 0) ? 1 : first;
+	int vlast = (last < width - 2) ? last : width - 2;
+	int vend = vstart;
+	if (vlast > vstart)
+		vend += ((vlast - vstart)/lanes)*lanes;
+
+	for (int y = srcy; y < srcy + srch; y++)
+	{
+		const Uint32* row5 = (const Uint32*) (src + y*src_pitch) + vstart;
+		const Uint32* rowB = (y == 0) ? row5 : row5 - width;
+		const Uint32* row2 = (y >= src_height - 1) ? row5 : row5 + width;
+		const Uint32* rowA = (y >= src_height - 2) ? row2 : row2 + width;
+		Uint32* d0 = (Uint32*) (dst + (dsty + 2*(y - srcy))*dst_pitch) + dstx + 2*(vstart - srcx);
+		Uint32* d1 = (Uint32*) ((unsigned char*) d0 + dst_pitch);
+
+		for (int x = vstart; x < vend; x += lanes)
+		{
+			if (eagle)
+				eagle_block<V>(blend, rowB, row5, row2, rowA, d0, d1);
+			else
+				sai_block<V>(blend, rowB, row5, row2, rowA, d0, d1);
+			rowB += lanes;
+			row5 += lanes;
+			row2 += lanes;
+			rowA += lanes;
+			d0 += 2*lanes;
+			d1 += 2*lanes;
+		}
+	}
+
+	if (vstart > first)
+		scalar(src, first, srcy, vstart - first, srch, src_pitch, src_height,
+		       dst, dstx, dsty, dst_pitch);
+	if (last > vend)
+		scalar(src, vend, srcy, last - vend, srch, src_pitch, src_height,
+		       dst, dstx + 2*(vend - srcx), dsty, dst_pitch);
+}
+
+#define SCALE_ARGS unsigned char* src, int srcx, int srcy, int srcw, int srch, int src_pitch, int src_height, \
+                   unsigned char* dst, int dstx, int dsty, int dst_pitch
+#define SCALE_PASS src, srcx, srcy, srcw, srch, src_pitch, src_height, dst, dstx, dsty, dst_pitch
+
+__attribute__((target("sse2"))) static void Super2xSaI_sse2(SCALE_ARGS)
+{
+	scale_simd<sai_v4, false>(SCALE_PASS);
+}
+
+__attribute__((target("avx2"))) static void Super2xSaI_avx2(SCALE_ARGS)
+{
+	scale_simd<sai_v8, false>(SCALE_PASS);
+}
+
+__attribute__((target("sse2"))) static void Scale_SuperEagle_sse2(SCALE_ARGS)
+{
+	scale_simd<sai_v4, true>(SCALE_PASS);
+}
+
+__attribute__((target("avx2"))) static void Scale_SuperEagle_avx2(SCALE_ARGS)
+{
+	scale_simd<sai_v8, true>(SCALE_PASS);
+}
+
+#undef SCALE_ARGS
+#undef SCALE_PASS
+#undef V_EQ
+#undef V_NE
+#undef SAI_INLINE
+
+#endif // SIMD kernels
+
+// Picks the fastest kernels this CPU can run
+static void choose_scale_kernels()
+{
+	sai_func = Super2xSaI_ex2;
+	eagle_func = Scale_SuperEagle;
+#ifdef SAI_SIMD
+	if (SDL_HasAVX2())
+	{
+		sai_func = Super2xSaI_avx2;
+		eagle_func = Scale_SuperEagle_avx2;
+		Log("Scaling with AVX2\n");
+	}
+	else if (SDL_HasSSE2())
+	{
+		sai_func = Super2xSaI_sse2;
+		eagle_func = Scale_SuperEagle_sse2;
+		Log("Scaling with SSE2\n");
+	}
+#endif
+}
+
+
+// Scaling the whole screen is split into horizontal bands.  The caller
+// does the first band and a few worker threads do the others.
+#define MAX_SCALE_THREADS 4
+
+struct ScaleJob
+{
+	ScaleFunc func;
+	int scale;
+	unsigned char* src;
+	int srcx, srcy, srcw, srch, src_pitch, src_height;
+	unsigned char* dst;
+	int dstx, dsty, dst_pitch;
+};
+
+static ScaleJob scale_job;
+static int scale_bands = 1;
+static bool scale_quit = false;
+static SDL_Thread* scale_threads[MAX_SCALE_THREADS];
+static SDL_sem* scale_start[MAX_SCALE_THREADS];
+static SDL_sem* scale_done = NULL;
+
+static void run_scale_band(int band)
+{
+	int y0 = scale_job.srch*band/scale_bands;
+	int y1 = scale_job.srch*(band + 1)/scale_bands;
+
+	if (y1 > y0)
+		scale_job.func(scale_job.src, scale_job.srcx, scale_job.srcy + y0, scale_job.srcw, y1 - y0,
+		               scale_job.src_pitch, scale_job.src_height,
+		               scale_job.dst, scale_job.dstx, scale_job.dsty + scale_job.scale*y0, scale_job.dst_pitch);
+}
+
+static int scale_worker(void* data)
+{
+	int band = (int) (size_t) data;
+
+	while (1)
+	{
+		SDL_SemWait(scale_start[band]);
+		if (scale_quit)
+			break;
+		run_scale_band(band);
+		SDL_SemPost(scale_done);
+	}
+	return 0;
+}
+
+static void start_scale_threads()
+{
+	if (scale_done != NULL)
+		return;
+
+	int cpus = SDL_GetCPUCount();
+	if (cpus > MAX_SCALE_THREADS)
+		cpus = MAX_SCALE_THREADS;
+	if (cpus < 2)
+		return;
+
+	scale_quit = false;
+	scale_done = SDL_CreateSemaphore(0);
+	for (int i = 1; i < cpus; i++)
+	{
+		scale_start[i] = SDL_CreateSemaphore(0);
+		scale_threads[i] = SDL_CreateThread(scale_worker, "scaler", (void*) (size_t) i);
+		if (scale_threads[i] == NULL)
+		{
+			Log("Could not start scaling thread: %s\n", SDL_GetError());
+			SDL_DestroySemaphore(scale_start[i]);
+			break;
+		}
+		scale_bands = i + 1;
+	}
+}
+
+static void stop_scale_threads()
+{
+	if (scale_done == NULL)
+		return;
+
+	scale_quit = true;
+	for (int i = 1; i < scale_bands; i++)
+	{
+		SDL_SemPost(scale_start[i]);
+		SDL_WaitThread(scale_threads[i], NULL);
+		SDL_DestroySemaphore(scale_start[i]);
+	}
+	SDL_DestroySemaphore(scale_done);
+	scale_done = NULL;
+	scale_bands = 1;
+}
+
+static void scale_in_bands(ScaleFunc func, int scale,
+	unsigned char* src,
+	int srcx, int srcy,
+	int srcw, int srch,
+	int src_pitch,
+	int src_height,
+	unsigned char* dst,
+	int dstx,
+	int dsty,
+	int dst_pitch )
+{
+	ScaleJob job = {func, scale, src, srcx, srcy, srcw, srch, src_pitch, src_height, dst, dstx, dsty, dst_pitch};
+	scale_job = job;
+
+	for (int i = 1; i < scale_bands; i++)
+		SDL_SemPost(scale_start[i]);
+	run_scale_band(0);
+	for (int i = 1; i < scale_bands; i++)
+		SDL_SemWait(scale_done);
+}
+
+
+// Exact integer scaling: every pixel becomes a scale x scale block.  Each
+// source row is widened once and then copied down.
+template <int scale>
+static void Nearest_ex(
+	unsigned char* src,
+	int srcx, int srcy,
+	int srcw, int srch,
+	int src_pitch,
+	int src_height,
+	unsigned char* dst,
+	int dstx,
+	int dsty,
+	int dst_pitch )
+{
+	int width = src_pitch/4;
+
+	if (srcx + srcw >= width)
+		srcw = width - srcx;
+
+	for (int y = srcy; y < srcy + srch; y++)
+	{
+		const Uint32* s = (const Uint32*) (src + y*src_pitch) + srcx;
+		unsigned char* row = dst + (dsty + scale*(y - srcy))*dst_pitch + 4*dstx;
+		Uint32* d = (Uint32*) row;
+
+		for (int x = 0; x < srcw; x++)
+			for (int i = 0; i < scale; i++)
+				*d++ = s[x];
+		for (int i = 1; i < scale; i++)
+			memcpy(row + i*dst_pitch, row, 4*scale*srcw);
+	}
+}
+
+// Scale2x (EPX): each corner of the 2x2 block takes the color of the
+// two neighbors next to it when they match, and the pixel's own otherwise
+//   B        E0 E1
+// D E F  ->  E2 E3
+//   H
+static void Scale2x_ex(
+	unsigned char* src,
+	int srcx, int srcy,
+	int srcw, int srch,
+	int src_pitch,
+	int src_height,
+	unsigned char* dst,
+	int dstx,
+	int dsty,
+	int dst_pitch )
+{
+	int width = src_pitch/4;
+
+	if (srcx + srcw >= width)
+		srcw = width - srcx;
+
+	for (int y = srcy; y < srcy + srch; y++)
+	{
+		const Uint32* rowE = (const Uint32*) (src + y*src_pitch);
+		const Uint32* rowB = (y == 0) ? rowE : rowE - width;
+		const Uint32* rowH = (y >= src_height - 1) ? rowE : rowE + width;
+		Uint32* d0 = (Uint32*) (dst + (dsty + 2*(y - srcy))*dst_pitch) + dstx;
+		Uint32* d1 = (Uint32*) ((unsigned char*) d0 + dst_pitch);
+
+		for (int x = srcx; x < srcx + srcw; x++)
+		{
+			Uint32 E = rowE[x], B = rowB[x], H = rowH[x];
+			Uint32 D = (x > 0) ? rowE[x-1] : E;
+			Uint32 F = (x < width - 1) ? rowE[x+1] : E;
+
+			if (B != H && D != F)
+			{
+				d0[0] = (D == B) ? D : E;
+				d0[1] = (B == F) ? F : E;
+				d1[0] = (D == H) ? D : E;
+				d1[1] = (H == F) ? F : E;
+			}
+			else
+				d0[0] = d0[1] = d1[0] = d1[1] = E;
+
+			d0 += 2;
+			d1 += 2;
+		}
+	}
+}
+
+// Scale3x, the same idea on a 3x3 block, using the diagonals too
+// A B C     E0 E1 E2
+// D E F  -> E3 E4 E5
+// G H I     E6 E7 E8
+static void Scale3x_ex(
+	unsigned char* src,
+	int srcx, int srcy,
+	int srcw, int srch,
+	int src_pitch,
+	int src_height,
+	unsigned char* dst,
+	int dstx,
+	int dsty,
+	int dst_pitch )
+{
+	int width = src_pitch/4;
+
+	if (srcx + srcw >= width)
+		srcw = width - srcx;
+
+	for (int y = srcy; y < srcy + srch; y++)
+	{
+		const Uint32* rowE = (const Uint32*) (src + y*src_pitch);
+		const Uint32* rowB = (y == 0) ? rowE : rowE - width;
+		const Uint32* rowH = (y >= src_height - 1) ? rowE : rowE + width;
+		Uint32* d0 = (Uint32*) (dst + (dsty + 3*(y - srcy))*dst_pitch) + dstx;
+		Uint32* d1 = (Uint32*) ((unsigned char*) d0 + dst_pitch);
+		Uint32* d2 = (Uint32*) ((unsigned char*) d1 + dst_pitch);
+
+		for (int x = srcx; x < srcx + srcw; x++)
+		{
+			int left = (x > 0) ? x - 1 : x;
+			int right = (x < width - 1) ? x + 1 : x;
+			Uint32 A = rowB[left], B = rowB[x], C = rowB[right];
+			Uint32 D = rowE[left], E = rowE[x], F = rowE[right];
+			Uint32 G = rowH[left], H = rowH[x], I = rowH[right];
+
+			if (B != H && D != F)
+			{
+				d0[0] = (D == B) ? D : E;
+				d0[1] = ((D == B && E != C) || (B == F && E != A)) ? B : E;
+				d0[2] = (B == F) ? F : E;
+				d1[0] = ((D == B && E != G) || (D == H && E != A)) ? D : E;
+				d1[1] = E;
+				d1[2] = ((B == F && E != I) || (H == F && E != C)) ? F : E;
+				d2[0] = (D == H) ? D : E;
+				d2[1] = ((D == H && E != I) || (H == F && E != G)) ? H : E;
+				d2[2] = (H == F) ? F : E;
+			}
+			else
+				d0[0] = d0[1] = d0[2] = d1[0] = d1[1] = d1[2] = d2[0] = d2[1] = d2[2] = E;
+
+			d0 += 3;
+			d1 += 3;
+			d2 += 3;
+		}
+	}
+}
+
+int query_engine_scale(RenderEngine engine)
+{
+	switch(engine)
+	{
+		case SAI:
+		case EAGLE:
+		case NEAREST2X:
+		case SCALE2X:
+			return 2;
+		case NEAREST3X:
+		case SCALE3X:
+			return 3;
+		case NEAREST4X:
+			return 4;
+		default:
+			return 1;
+	}
+}
+
+// The filter that scales 'render' for the engine, or NULL when it is shown as is
+static ScaleFunc query_scale_func(RenderEngine engine)
+{
+	switch(engine)
+	{
+		case SAI:
+			return sai_func;
+		case EAGLE:
+			return eagle_func;
+		case NEAREST2X:
+			return Nearest_ex<2>;
+		case NEAREST3X:
+			return Nearest_ex<3>;
+		case NEAREST4X:
+			return Nearest_ex<4>;
+		case SCALE2X:
+			return Scale2x_ex;
+		case SCALE3X:
+			return Scale3x_ex;
+		default:
+			return NULL;
+	}
+}
+
 
 void Super2xSaI_ex(unsigned char *src, Uint32 src_pitch, unsigned char *unused, unsigned char *dest, Uint32 dest_pitch, Uint32 width, Uint32 height) 
 {
@@ -681,61 +1296,100 @@ Screen::Screen( RenderEngine engine, int width, int height, int fullscreen)
 	{
 	case SAI:
 		Init_2xSaI();
+		start_scale_threads();
 		break;
 	case EAGLE:
 		Init_2xSaI();
+		start_scale_threads();
+		break;
+	case SCALE2X:
+	case SCALE3X:
+		start_scale_threads();
 		break;
 	default:
 		break;
 	}
     
-    int w, h;
-    #ifdef ANDROID
-    w = 0;
-    h = 0;
-    fullscreen = true;
-    #else
-    w = width;
-    h = height;
-    #endif
-
-    Uint32 window_flags = SDL_WINDOW_SHOWN;
-    if(fullscreen)
-        window_flags |= SDL_WINDOW_FULLSCREEN_DESKTOP;
+    if(Engine == HEADLESS)
+    {
+        // Nothing is ever shown, so there is no window or renderer and no
+        // vsync to wait for.  Input still maps onto a 320x200 "window".
+        window = NULL;
+        renderer = NULL;
+        window_w = 320;
+        window_h = 200;
+        update_overscan_setting();
+    }
+    else
+    {
+        int w, h;
+        #ifdef ANDROID
+        w = 0;
+        h = 0;
+        fullscreen = true;
+        #else
+        w = width;
+        h = height;
+        #endif
+
+        Uint32 window_flags = SDL_WINDOW_SHOWN;
+        if(fullscreen)
+            window_flags |= SDL_WINDOW_FULLSCREEN_DESKTOP;
     
-    #ifdef __IPHONEOS__
-    window_flags |= SDL_WINDOW_BORDERLESS;
-    #endif
+        #ifdef __IPHONEOS__
+        window_flags |= SDL_WINDOW_BORDERLESS;
+        #endif
     
-    window = SDL_CreateWindow("Gladiator",
-                        SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED,
-                        w, h,
-                        window_flags);
-    if(window == NULL)
-        exit(1);
+        window = SDL_CreateWindow("Gladiator",
+                            SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED,
+                            w, h,
+                            window_flags);
+        if(window == NULL)
+            exit(1);
     
-    SDL_GetWindowSize(window, &w, &h);
-    window_w = w;
-    window_h = h;
+        SDL_GetWindowSize(window, &w, &h);
+        window_w = w;
+        window_h = h;
     
-    update_overscan_setting();
+        update_overscan_setting();
     
-    renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_PRESENTVSYNC);
+        renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_PRESENTVSYNC);
+    }
     
+    framebuffer = new Uint8[320*200];
+    memset(framebuffer, 0, 320*200);
     render = SDL_CreateRGBSurface(SDL_SWSURFACE, 320, 200, 32, 0, 0, 0, 0);
-	render_tex = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STREAMING, 320, 200);
+    set_palette_lookup_format(render->format);
+	render_tex = NULL;
+	if(renderer != NULL)
+		render_tex = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STREAMING, 320, 200);
     render2 = NULL;  // To be initialized when we actually need it
     render2_tex = NULL;
+    
+    // Nothing has been resolved yet, so the first swap does it all
+    num_dirty = 0;
+    dirty_lock = 0;
+    resolved_frame = new Uint8[320*200];
+    resolved_palette = query_palette_serial();
+    render_stale = true;
+    render_behind = false;
 }
 
 Screen::~Screen()
 {
-	SDL_DestroyTexture(render_tex);
-	SDL_DestroyTexture(render2_tex);
+	stop_scale_threads();
+	if(render_tex != NULL)
+		SDL_DestroyTexture(render_tex);
+	if(render2_tex != NULL)
+		SDL_DestroyTexture(render2_tex);
+	set_palette_lookup_format(NULL);
 	SDL_FreeSurface(render);
 	SDL_FreeSurface(render2);
+	delete[] framebuffer;
+	delete[] resolved_frame;
 	
-	SDL_DestroyRenderer(renderer);
+	if(renderer != NULL)
+		SDL_DestroyRenderer(renderer);
 	//SDL_DestroyWindow(window);
 }
 
@@ -747,55 +1401,299 @@ void Screen::SaveBMP(SDL_Surface* screen, char* filename)
 
 void Screen::clear()
 {
-	SDL_FillRect(render, NULL, 0x000000);
+	memset(framebuffer, 0, render->w*render->h);
+	mark_dirty(0, 0, render->w, render->h);
 }
 
 void Screen::clear(int x, int y, int w, int h)
 {
-    SDL_Rect r = {x, y, w, h};
-	SDL_FillRect(render, &r, 0x000000);
+    if(x < 0)
+    {
+        w += x;
+        x = 0;
+    }
+    if(y < 0)
+    {
+        h += y;
+        y = 0;
+    }
+    if(x + w > render->w)
+        w = render->w - x;
+    if(y + h > render->h)
+        h = render->h - y;
+    if(w <= 0 || h <= 0)
+        return;
+    
+    for(int j = y; j < y + h; j++)
+        memset(framebuffer + j*render->w + x, 0, w);
+    mark_dirty(x, y, w, h);
+}
+
+// Records that a part of the framebuffer changed.  Areas that touch are
+// merged, and if there are too many they all collapse into one.
+void Screen::mark_dirty(int x, int y, int w, int h)
+{
+    if(x < 0)
+    {
+        w += x;
+        x = 0;
+    }
+    if(y < 0)
+    {
+        h += y;
+        y = 0;
+    }
+    if(x + w > render->w)
+        w = render->w - x;
+    if(y + h > render->h)
+        h = render->h - y;
+    if(w <= 0 || h <= 0)
+        return;
+    
+    // Viewscreens can be drawing on several threads
+    SDL_AtomicLock(&dirty_lock);
+    
+    // Most marks land inside something already dirty
+    int i;
+    for(i = 0; i < num_dirty; i++)
+    {
+        if(x >= dirty[i].x && y >= dirty[i].y
+           && x + w <= dirty[i].x + dirty[i].w && y + h <= dirty[i].y + dirty[i].h)
+        {
+            SDL_AtomicUnlock(&dirty_lock);
+            return;
+        }
+    }
+    
+    int x2 = x + w, y2 = y + h;
+    i = 0;
+    while(i < num_dirty)
+    {
+        SDL_Rect& r = dirty[i];
+        if(x <= r.x + r.w && r.x <= x2 && y <= r.y + r.h && r.y <= y2)
+        {
+            // Take it over and start again, the bigger area may touch others
+            if(r.x < x)
+                x = r.x;
+            if(r.y < y)
+                y = r.y;
+            if(r.x + r.w > x2)
+                x2 = r.x + r.w;
+            if(r.y + r.h > y2)
+                y2 = r.y + r.h;
+            dirty[i] = dirty[--num_dirty];
+            i = 0;
+        }
+        else
+            i++;
+    }
+    
+    if(num_dirty == MAX_DIRTY_RECTS)
+    {
+        for(i = 0; i < num_dirty; i++)
+        {
+            if(dirty[i].x < x)
+                x = dirty[i].x;
+            if(dirty[i].y < y)
+                y = dirty[i].y;
+            if(dirty[i].x + dirty[i].w > x2)
+                x2 = dirty[i].x + dirty[i].w;
+            if(dirty[i].y + dirty[i].h > y2)
+                y2 = dirty[i].y + dirty[i].h;
+        }
+        num_dirty = 0;
+    }
+    
+    SDL_Rect rect = {x, y, x2 - x, y2 - y};
+    dirty[num_dirty++] = rect;
+    SDL_AtomicUnlock(&dirty_lock);
+}
+
+// Converts the whole indexed framebuffer into 'render' through
+// the cached lookup table of the current palette
+void Screen::resolve()
+{
+    resolve(0, 0, render->w, render->h);
+    render_behind = false;
+}
+
+void Screen::resolve(int x, int y, int w, int h)
+{
+    SDL_LockSurface(render);
+    resolve_into((Uint8*)render->pixels + y*render->pitch + 4*x, render->pitch, x, y, w, h);
+    SDL_UnlockSurface(render);
+}
+
+// Writes the colors of a part of the framebuffer to 'dest', which points
+// at the top left of that part
+void Screen::resolve_into(Uint8* dest, int dest_pitch, int x, int y, int w, int h)
+{
+    const Uint32* lut = query_palette_lookup();
+    
+    for(int j = y; j < y + h; j++)
+    {
+        Uint8* src = framebuffer + j*render->w + x;
+        Uint32* row = (Uint32*)(dest + (j - y)*dest_pitch);
+        for(int i = 0; i < w; i++)
+            row[i] = lut[src[i]];
+        memcpy(resolved_frame + j*render->w + x, src, w);
+    }
+}
+
+// Resolves a part of the framebuffer and gets it into the texture.  At
+// 1x the colors go straight into the locked texture and 'render' falls
+// behind; the scaling engines need 'render' as their source.
+void Screen::output(int x, int y, int w, int h)
+{
+    if(renderer != NULL && query_engine_scale(Engine) == 1)
+    {
+        SDL_Rect rect = {x, y, w, h};
+        void* pixels;
+        int pitch;
+        if(SDL_LockTexture(render_tex, &rect, &pixels, &pitch) == 0)
+        {
+            resolve_into((Uint8*)pixels, pitch, x, y, w, h);
+            SDL_UnlockTexture(render_tex);
+            render_behind = true;
+            return;
+        }
+    }
+    
+    resolve(x, y, w, h);
+    update(x, y, w, h);
 }
 
+// The frame as it is on screen, at the engine's size
+SDL_Surface* Screen::snapshot()
+{
+    if(render_behind)
+        resolve();
+    
+    int scale = query_engine_scale(Engine);
+    ScaleFunc func = query_scale_func(Engine);
+    if(func == NULL)
+        return render;
+    
+    if(render2 == NULL)
+        render2 = SDL_CreateRGBSurface(SDL_SWSURFACE, scale*render->w, scale*render->h, 32, 0, 0, 0, 0);
+    SDL_LockSurface(render2);
+    scale_in_bands(func, scale,
+            (unsigned char*) render->pixels, 0, 0, render->w, render->h, render->pitch, render->h,
+            (unsigned char*) render2->pixels, 0, 0, render2->pitch);
+    SDL_UnlockSurface(render2);
+    return render2;
+}
+
+// Shows everything drawn since the last swap.  Only the dirty parts of
+// the framebuffer are resolved, scaled and uploaded (all of it after a
+// palette change); the rest of the texture is still current.  The rect
+// is what the caller needs shown, which is always covered by that.
 void Screen::swap(int x, int y, int w, int h)
 {
-    SDL_Surface* source_surface = render;
-    SDL_Texture* dest_texture = render_tex;
+    query_palette_lookup();
+    if(render_stale || resolved_palette != query_palette_serial())
+    {
+        output(0, 0, render->w, render->h);
+        resolved_palette = query_palette_serial();
+        render_stale = false;
+        num_dirty = 0;
+    }
     
-	switch(Engine) {
-		case SAI:
-                if(render2 == NULL)
-                {
-                    render2 = SDL_CreateRGBSurface(SDL_SWSURFACE, 640, 400, 32, 0, 0, 0, 0);
-                    render2_tex = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STREAMING, 640, 400);
-                }
-                SDL_LockSurface( render2 );
-                Super2xSaI_ex2(
-                        (unsigned char*) render->pixels, x, y, w, h, render->pitch, render->h,
-                        (unsigned char*) render2->pixels, 2*x, 2*y, render2->pitch);
-                SDL_UnlockSurface( render2 );
-                
-                source_surface = render2;
-                dest_texture = render2_tex;
-            break;
-		case EAGLE:
-                if(render2 == NULL)
-                {
-                    render2 = SDL_CreateRGBSurface(SDL_SWSURFACE, 640, 400, 32, 0, 0, 0, 0);
-                    render2_tex = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STREAMING, 640, 400);
-                }
-                SDL_LockSurface( render2 );
-                Scale_SuperEagle((unsigned char*) render->pixels, x, y, w, h, render->pitch, render->h,
-                                 (unsigned char*) render2->pixels, 2*x, 2*y, render2->pitch);
-                SDL_UnlockSurface( render2 );
-                
-                source_surface = render2;
-                dest_texture = render2_tex;
-			break;
-        default:
-            break;
-	}
-	
-    SDL_UpdateTexture(dest_texture, NULL, source_surface->pixels, source_surface->pitch);
+    for(int i = 0; i < num_dirty; i++)
+    {
+        // Menus redraw everything each frame; drop the rows that came
+        // out the same as what is already showing
+        int top = dirty[i].y, bottom = dirty[i].y + dirty[i].h;
+        int offset = dirty[i].x, len = dirty[i].w;
+        while(top < bottom && memcmp(framebuffer + top*render->w + offset,
+                                     resolved_frame + top*render->w + offset, len) == 0)
+            top++;
+        while(bottom > top && memcmp(framebuffer + (bottom-1)*render->w + offset,
+                                     resolved_frame + (bottom-1)*render->w + offset, len) == 0)
+            bottom--;
+        if(top == bottom)
+            continue;
+        
+        output(dirty[i].x, top, dirty[i].w, bottom - top);
+    }
+    num_dirty = 0;
+    
+    show();
+}
+
+// Scales and shows 'render' as it is, without resolving the framebuffer first
+void Screen::present(int x, int y, int w, int h)
+{
+    // Whatever was drawn into 'render' is replaced on the next swap
+    render_stale = true;
+    render_behind = false;
+    update(x, y, w, h);
+    show();
+}
+
+// Scales a part of 'render' for the engine into the texture.  The filters
+// write straight into the locked texture, so there is no copy to upload.
+void Screen::update(int x, int y, int w, int h)
+{
+    // Headless frames end in 'render'
+    if(renderer == NULL)
+        return;
+    
+    ScaleFunc func = query_scale_func(Engine);
+    if(func == NULL)
+    {
+        SDL_Rect rect = {x, y, w, h};
+        SDL_UpdateTexture(render_tex, &rect,
+                          (Uint8*)render->pixels + y*render->pitch + 4*x, render->pitch);
+        return;
+    }
+    
+    // The filters read up to two pixels around each one, so their
+    // output changes that far from what was drawn
+    x -= 2;
+    y -= 2;
+    w += 4;
+    h += 4;
+    if(x < 0)
+    {
+        w += x;
+        x = 0;
+    }
+    if(y < 0)
+    {
+        h += y;
+        y = 0;
+    }
+    if(x + w > render->w)
+        w = render->w - x;
+    if(y + h > render->h)
+        h = render->h - y;
+    
+    int scale = query_engine_scale(Engine);
+    if(render2_tex == NULL)
+        render2_tex = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STREAMING, scale*render->w, scale*render->h);
+    
+    // Every pixel of the locked rect is written, as SDL requires
+    SDL_Rect rect = {scale*x, scale*y, scale*w, scale*h};
+    void* pixels;
+    int pitch;
+    if(SDL_LockTexture(render2_tex, &rect, &pixels, &pitch) < 0)
+        return;
+    scale_in_bands(func, scale,
+            (unsigned char*) render->pixels, x, y, w, h, render->pitch, render->h,
+            (unsigned char*) pixels, 0, 0, pitch);
+    SDL_UnlockTexture(render2_tex);
+}
+
+// Puts the current texture in the window
+void Screen::show()
+{
+    if(renderer == NULL)
+        return;
+    
+    SDL_Texture* dest_texture = render_tex;
+    if(query_engine_scale(Engine) > 1 && render2_tex != NULL)
+        dest_texture = render2_tex;
     
     SDL_Rect dest = {int(viewport_offset_x), int(viewport_offset_y), int(viewport_w), int(viewport_h)};
 
@@ -808,7 +1706,13 @@ void Screen::clear_window()
     SDL_Surface* source_surface = render;
     SDL_Texture* dest_texture = render_tex;
     
+    clear();
     SDL_FillRect(source_surface, NULL, 0x000000);
+    render_stale = true;
+    render_behind = false;
+    
+    if(renderer == NULL)
+        return;
     
     SDL_UpdateTexture(dest_texture, NULL, source_surface->pixels, source_surface->pitch);
     
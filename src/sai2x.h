@@ -8,28 +8,59 @@ typedef enum
 	NoZoom = 0x01,
 	SAI = 0x02,
 	EAGLE = 0x03,
-	DOUBLE = 0x04
+	DOUBLE = 0x04,
+	NEAREST2X = 0x05,
+	NEAREST3X = 0x06,
+	NEAREST4X = 0x07,
+	SCALE2X = 0x08,
+	SCALE3X = 0x09,
+	HEADLESS = 0x0A  // no window: frames are only resolved into 'render'
 } RenderEngine;
 
+// How many times larger than 320x200 the engine's output is
+int query_engine_scale(RenderEngine engine);
+
+// More separate dirty areas than this are merged into one
+#define MAX_DIRTY_RECTS 16
+
 class Screen
 {
 	public:
 		RenderEngine Engine;  // how to render the physical screen
 		
+		// Both NULL for the HEADLESS engine
 		SDL_Window* window;
 		SDL_Renderer* renderer;
 		
-		// The target for all rendering
+		// The target for all drawing: 8-bit palette indices, 320x200
+		Uint8* framebuffer;
+		
+		// The ARGB surface 'framebuffer' is resolved into on swap
 		SDL_Surface* render;
 		
-		// A texture updated by 'render' for normal rendering
+		// A texture updated by 'render' for normal rendering (NULL when headless)
 		SDL_Texture* render_tex;
 		
-		// A buffer for doubling filters (i.e. Sai or Eagle)
+		// The scaled frame for snapshot(), sized to the engine's factor.  Each
+		// frame is scaled straight into render2_tex instead.
         SDL_Surface* render2;
         // A larger texture for the doubled result
         SDL_Texture* render2_tex;
         
+        // The parts of 'framebuffer' drawn to since the last swap, coalesced
+        SDL_Rect dirty[MAX_DIRTY_RECTS];
+        int num_dirty;
+        SDL_SpinLock dirty_lock;
+        // What 'framebuffer' held when it was last resolved, so rows that
+        // were drawn over with the same pixels can be skipped
+        Uint8* resolved_frame;
+        // query_palette_serial() of the colors in 'render'
+        int resolved_palette;
+        // 'render' was drawn to directly and no longer matches resolved_frame
+        bool render_stale;
+        // Frames were resolved straight into the texture since 'render' was
+        bool render_behind;
+        
 		Screen(RenderEngine engine, int width, int height, int fullscreen);
 		~Screen();
 
@@ -37,7 +68,16 @@ class Screen
 
         void clear();
         void clear(int x, int y, int w, int h);
+        void mark_dirty(int x, int y, int w, int h);
 		void swap(int x, int y, int w, int h);
+		void resolve();
+		void resolve(int x, int y, int w, int h);
+		void resolve_into(Uint8* dest, int dest_pitch, int x, int y, int w, int h);
+		void output(int x, int y, int w, int h);
+		SDL_Surface* snapshot();
+		void update(int x, int y, int w, int h);
+		void present(int x, int y, int w, int h);
+		void show();
 		
 		void clear_window();
 
@@ -38,7 +38,6 @@ using namespace std;
 extern Sint32 calculate_level(Uint32 temp_exp);
 
 // Screen window boundries
-#define MAX_VIEWS 5
 #define S_UP 0 //12 //0
 #define S_LEFT 0 //12 //0
 #define S_DOWN 200 //188 // 200
@@ -47,7 +46,7 @@ extern Sint32 calculate_level(Uint32 temp_exp);
 #define S_HEIGHT (S_DOWN - S_UP)
 //#define BUF_SIZE (unsigned) ((S_DOWN-S_UP)*(S_RIGHT-S_LEFT))
 
-#define MAX_SPREAD 10 //this controls find_near_foe
+#define NEAR_FOE_RANGE 160 //this controls find_near_foe
 
 short load_version_2(SDL_RWops  *infile, screen * master);
 short load_version_3(SDL_RWops  *infile, screen * master); // v.3 scen
@@ -64,6 +63,17 @@ Uint32 random(Uint32 x)
 	return (Uint32) ( ((Uint32) rand()) % x);
 }
 
+// Like random(), but from a seed of the caller's own, for drawing that
+// may run off the main thread (see viewscreen::draw_seed).  rand() is
+// neither safe there nor would the game stay the same run to run.
+Uint32 random_from(Uint32& seed, Uint32 x)
+{
+	seed = seed*1103515245 + 12345;
+	if (x < 1)
+		return 0;
+	return (seed >> 16) % x;
+}
+
 // ************************************************************
 //  SCREEN -- graphics routines
 //
@@ -233,6 +243,7 @@ screen::screen(short howmany)
 
 screen::~screen()
 {
+	stop_view_threads();
 	release_timer();
 	delete soundp;
 
@@ -611,11 +622,141 @@ void screen::clear()
 //           finding which grid squares are on screen.  For each on
 //           screen, it pashorts the appropriate graphics pixie onto
 //           the screen by calling the function DRAW in PIXIE.
+// Viewscreens draw into their own parts of the buffer, so with more
+// than one they are split among a few worker threads.  Each thread takes
+// every view_bands'th view; the caller takes the first ones.
+static SDL_Thread* view_threads[MAX_VIEWS];
+static SDL_sem* view_start[MAX_VIEWS];
+static SDL_sem* view_done = NULL;
+static int view_bands = 1;
+static bool view_quit = false;
+static viewscreen* view_jobs[MAX_VIEWS];
+static int num_view_jobs = 0;
+static LevelData* view_level = NULL;
+
+static void draw_view_band(int band)
+{
+	for (int i = band; i < num_view_jobs; i += view_bands)
+		view_jobs[i]->draw_prepared(view_level);
+}
+
+static int view_worker(void* data)
+{
+	int band = (int) (size_t) data;
+
+	while (1)
+	{
+		SDL_SemWait(view_start[band]);
+		if (view_quit)
+			break;
+		draw_view_band(band);
+		SDL_SemPost(view_done);
+	}
+	return 0;
+}
+
+void screen::start_view_threads()
+{
+	if (view_done != NULL)
+		return;
+
+	int cpus = SDL_GetCPUCount();
+	if (cpus > MAX_VIEWS)
+		cpus = MAX_VIEWS;
+	if (cpus < 2)
+		return;
+
+	// The views look colors up in it as they draw
+	ready_inverse_palette();
+
+	view_quit = false;
+	view_done = SDL_CreateSemaphore(0);
+	for (int i = 1; i < cpus; i++)
+	{
+		view_start[i] = SDL_CreateSemaphore(0);
+		view_threads[i] = SDL_CreateThread(view_worker, "viewscreen", (void*) (size_t) i);
+		if (view_threads[i] == NULL)
+		{
+			Log("Could not start viewscreen thread: %s\n", SDL_GetError());
+			SDL_DestroySemaphore(view_start[i]);
+			break;
+		}
+		view_bands = i + 1;
+	}
+}
+
+void screen::stop_view_threads()
+{
+	if (view_done == NULL)
+		return;
+
+	view_quit = true;
+	for (int i = 1; i < view_bands; i++)
+	{
+		SDL_SemPost(view_start[i]);
+		SDL_WaitThread(view_threads[i], NULL);
+		SDL_DestroySemaphore(view_start[i]);
+	}
+	SDL_DestroySemaphore(view_done);
+	view_done = NULL;
+	view_bands = 1;
+}
+
+// Whether the viewscreens can draw at once: not if any two overlap, as
+// they can when a player picks a bigger view
+bool screen::views_apart()
+{
+	for (short i = 0; i < numviews; i++)
+		for (short j = i+1; j < numviews; j++)
+		{
+			viewscreen* a = viewob[i];
+			viewscreen* b = viewob[j];
+			if (a->xloc < b->endx && b->xloc < a->endx
+			        && a->yloc < b->endy && b->yloc < a->endy)
+				return false;
+		}
+	return true;
+}
+
 short screen::redraw()
 {
 	short i;
+
+	// The bookkeeping goes in order, like it would drawing one by one
+	level_data.prepare_frame(numviews);
+	for (i=0; i < numviews; i++)
+		viewob[i]->prepare_redraw(&level_data);
+
+	bool apart = (numviews > 1 && views_apart());
+	if (apart)
+		start_view_threads();
+	if (!apart || view_done == NULL)
+	{
+		for (i=0; i < numviews; i++)
+			viewob[i]->draw_prepared(&level_data);
+		return 1;
+	}
+
 	for (i=0; i < numviews; i++)
-		viewob[i]->redraw();
+		view_jobs[i] = viewob[i];
+	num_view_jobs = numviews;
+	view_level = &level_data;
+
+	// Nothing another thread may be drawing from can be dropped meanwhile
+	PixieData::hold_team_spans();
+	text::hold_caches();
+	hold_blend_tables();
+
+	int bands = (view_bands < num_view_jobs ? view_bands : num_view_jobs);
+	for (i=1; i < bands; i++)
+		SDL_SemPost(view_start[i]);
+	draw_view_band(0);
+	for (i=1; i < bands; i++)
+		SDL_SemWait(view_done);
+
+	release_blend_tables();
+	text::release_caches();
+	PixieData::release_team_spans();
 
 	return 1;
 }
@@ -665,6 +806,7 @@ short screen::act()
 	//  static short debug = 0;
 
 	level_done = 2; // unless we find valid foes while looping
+	level_data.index_foes(); // everyone's moved since last frame
 
 	if (enemy_freeze)
 		enemy_freeze--;
@@ -683,9 +825,6 @@ short screen::act()
 				ob->in_act = 0;
 				if (ob && !ob->dead)
 				{
-					if (!ob->is_friendly_to_team(save_data.my_team) &&
-					        ob->query_order() == ORDER_LIVING)
-						level_done = 0;
 					// Testing .. trying to FORCE foes :)
 					if (ob->foe == NULL && ob->leader == NULL)
 						ob->foe = myscreen->find_far_foe(ob);
@@ -705,15 +844,7 @@ short screen::act()
 			               && (ob->query_order() != ORDER_GENERATOR)
 			          ) || (ob->team_num == 0) )
 			   )
-			{
 				ob->act();
-				if (ob && !ob->dead)
-				{
-					if (!ob->is_friendly_to_team(save_data.my_team) &&
-					        ob->query_order() == ORDER_LIVING)
-						level_done = 0;
-				}
-			}
 		}
 
 	}
@@ -734,6 +865,10 @@ short screen::act()
 		}
 	}  // end of weapons acting
 
+	// Anyone left standing against us?  Frozen enemies don't count.
+	if (level_data.count_foes_of_team(save_data.my_team, enemy_freeze != 0))
+		level_done = 0;
+
 	// Quickly check the background for exits, etc.
 	for(auto e = level_data.fxlist.begin(); e != level_data.fxlist.end(); e++)
 	{
@@ -787,6 +922,9 @@ short screen::act()
 	for(auto e = level_data.oblist.begin(); e != level_data.oblist.end();)
 	{
 	    walker* ob = *e;
+		// Not everyone who dies goes through walker::death()
+		if (ob && ob->dead)
+			level_data.count_living(ob);
 		if (ob && ob->dead && ob->myguy == NULL)
 		{
 		    // Delete the dead thing safely
@@ -804,6 +942,7 @@ short screen::act()
 			
 			// Save dead guys to be deleted later.  Delete everything else right now.  This is so the "owner" of weapons remains valid.
             level_data.dead_list.push_back(ob);
+            ob->mylevel = NULL;
             
             //level_data.remove_ob(ob);
             // Remove from the list directly here so we can preserve our iterator
@@ -946,64 +1085,18 @@ short screen::endgame(short ending, short nextlevel)
 
 walker *screen::find_near_foe(walker  *ob)
 {
-	short targx, targy;
-	short spread=1,xchange=0;
-	short loop=0;
-	short resolution = level_data.myobmap->obmapres;
+	walker *foe;
 
 	if (!ob)
 	{
 		Log("no ob in find near foe.\n");
 		return NULL;
 	}
-	targx = ob->xpos;
-	targy = ob->ypos;
-	spread = 1;
 
-	while (spread < MAX_SPREAD)
-	{
-		for (loop=0;loop<spread;loop++)
-		{
-			if (!(xchange%2))
-			{
-				targx += resolution; //changex is 0 or a mult of 2
-				if (targx<=0)
-					return find_far_foe(ob); //left edge of screen
-				if (targx>=level_data.pixmaxx)
-					return find_far_foe(ob); //right edge of screen
-			}
-			else
-			{
-				targy += resolution; //changex is odd
-				if (targy<=0)
-					return find_far_foe(ob); //top of screen
-				if (targy>=level_data.pixmaxy)
-					return find_far_foe(ob); //bottom of screen
-			}
-
-			std::list<walker*>& ls = level_data.myobmap->obmap_get_list(targx,targy);
-			for(auto e = ls.begin(); e != ls.end(); e++) //go through the list we received
-			{
-			    walker* w = *e;
-				if (!(w->dead) && (ob->is_friendly(w)==0)  &&
-				        (random(w->invisibility_left/20)==0)
-				   )
-				{
-					if (w->query_order() == ORDER_LIVING ||
-					        w->query_order() == ORDER_GENERATOR)
-						//done separately since they are logically more significant
-						return w; // this should be a valid foe
-				}
-			}//end inner while
-
-		}//end for
-		xchange++; //change whether we do x or y in each for loop
-		if (!(xchange%2))
-		{
-			resolution = (short) (-resolution); // reverse direction around the search every other for
-			spread++; // increase the search width every other for
-		}
-	}//end while
+	// Someone within a few squares, the nearest first
+	foe = level_data.find_nearest_foe(ob, NEAR_FOE_RANGE);
+	if (foe)
+		return foe;
 	//failure
 	return find_far_foe(ob);
 
@@ -1011,50 +1104,16 @@ walker *screen::find_near_foe(walker  *ob)
 
 walker  *screen::find_far_foe(walker  *ob)
 {
-	//short targx, targy;
-	Sint32 distance, tempdistance;
-	walker  *endfoe;
-
 	if (!ob)
 	{
 		Log("no ob in find far foe.\n");
 		return NULL;
 	}
 
-	// Get our current coordinates
-	//targx = ob->xpos;
-	//targy = ob->ypos;
-
-	// Set our 'default' foe to NULL
-	endfoe = NULL;
-	distance = 10000;
 	ob->stats->last_distance = 10000;
 
-    for(auto e = level_data.oblist.begin(); e != level_data.oblist.end(); e++)
-	{
-	    walker* foe = *e;
-		if (foe == NULL || foe->dead)
-			continue;
-        
-		// Check for valid objects ..
-		if (ob->is_friendly(foe) == 0)
-		{
-			if (
-			    (foe->query_order() == ORDER_LIVING ||
-			     foe->query_order() == ORDER_GENERATOR)  &&
-			    (!(random(foe->invisibility_left/20)))
-			)
-			{
-				tempdistance = ob->distance_to_ob(foe);
-				if (tempdistance < distance)
-				{
-					distance = tempdistance;
-					endfoe = foe;
-				}
-			}
-		}
-	}
-	return endfoe;
+	// Anyone at all, from the foes indexed for this frame
+	return level_data.find_nearest_foe(ob, 10000);
 }
 
 walker* screen::set_walker(walker *ob, char order, char family)
@@ -1181,33 +1240,9 @@ walker  * screen::find_nearest_blood(walker  *who)
 
 }
 
-std::list<walker*> screen::find_in_range(std::list<walker*>& somelist, Sint32 range, short *howmany, walker  *ob)
+short screen::find_in_range(walker  *ob, Sint32 range, Uint32 orders, std::vector<walker*>& result, bool by_distance)
 {
-	//short obx, oby;
-    std::list<walker*> result;
-    
-	*howmany = 0;
-	
-	if(!ob)
-		return result;
-
-	//obx = (short) (ob->xpos + (ob->sizex/2) );  // center of object
-	//oby = (short) (ob->ypos + (ob->sizey/2) );
-
-	for(auto e = somelist.begin(); e != somelist.end(); e++)
-	{
-	    walker* w = *e;
-		if (w && !w->dead)
-		{
-			if (ob->distance_to_ob(w) <= range)
-			{
-			    result.push_back(w);
-				(*howmany)++;
-			}
-		}
-	}
-
-	return result;
+	return level_data.myobmap->query_range(ob, range, RANGE_ANYONE, orders, result, by_distance);
 }
 
 walker* screen::find_nearest_player(walker *ob)
@@ -1236,59 +1271,17 @@ walker* screen::find_nearest_player(walker *ob)
 	return returnob;
 }
 
-std::list<walker*> screen::find_foes_in_range(std::list<walker*>& somelist, Sint32 range, short *howmany, walker  *ob)
+short screen::find_foes_in_range(walker  *ob, Sint32 range, std::vector<walker*>& result, bool by_distance)
 {
-    std::list<walker*> result;
-    *howmany = 0;
-    
-	if(!ob)
-		return result;
-
-	for(auto e = somelist.begin(); e != somelist.end(); e++)
-	{
-	    walker* w = *e;
-		if (w && !w->dead &&
-		        (w->query_order() == ORDER_LIVING ||
-		         w->query_order() == ORDER_GENERATOR)
-		        && (ob->is_friendly(w) == 0)
-		   )
-		{
-			if (ob->distance_to_ob(w) <= range)
-			{
-			    result.push_back(w);
-				(*howmany)++;
-			}
-		}
-	}
-
-	return result;
+	return level_data.myobmap->query_range(ob, range, RANGE_FOES,
+	                                       RANGE_ORDER(ORDER_LIVING) | RANGE_ORDER(ORDER_GENERATOR),
+	                                       result, by_distance);
 }
 
-std::list<walker*> screen::find_friends_in_range(std::list<walker*>& somelist, Sint32 range,
-                                      short *howmany, walker  *ob)
+short screen::find_friends_in_range(walker  *ob, Sint32 range, std::vector<walker*>& result, bool by_distance)
 {
-    std::list<walker*> result;
-    *howmany = 0;
-    
-	if(!ob)
-		return result;
-
-	for(auto e = somelist.begin(); e != somelist.end(); e++)
-	{
-	    walker* w = *e;
-		if (w && !w->dead && w->query_order() == ORDER_LIVING
-		        && ( ob->is_friendly(w) )
-		   )
-		{
-			if (ob->distance_to_ob(w) <= range)
-			{
-			    result.push_back(w);
-				(*howmany)++;
-			}
-		}
-	}
-
-	return result;
+	return level_data.myobmap->query_range(ob, range, RANGE_FRIENDS, RANGE_ORDER(ORDER_LIVING),
+	                                       result, by_distance);
 }
 
 std::list<walker*> screen::find_foe_weapons_in_range(std::list<walker*>& somelist, Sint32 range, short *howmany, walker  *ob)
@@ -1342,6 +1335,7 @@ char screen::damage_tile(short xloc, short yloc) // damage the specified tile
 		case PIX_GRASS3:
 		case PIX_GRASS4:
 			level_data.grid.data[gridloc] = PIX_GRASS1_DAMAGED;
+			level_data.update_background(xover, yover);
 			break;
 		default:
 			break;
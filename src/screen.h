@@ -49,6 +49,9 @@ class screen : public video
 		bool query_object_passable(float x, float y, walker  *ob);
 		bool query_grid_passable(float x, float y, walker  *ob);
 		short redraw();
+		bool views_apart();
+		void start_view_threads();
+		void stop_view_threads();
 		void refresh();
 		walker  * first_of(unsigned char whatorder, unsigned char whatfamily,
 		                   int team_num = -1);
@@ -63,9 +66,10 @@ class screen : public video
 		void draw_panels(short howmany);
 		walker* find_nearest_blood(walker *who);
 		walker* find_nearest_player(walker *ob);
-		std::list<walker*> find_in_range(std::list<walker*>& somelist, Sint32 range, short *howmany, walker  *ob);
-		std::list<walker*> find_foes_in_range(std::list<walker*>& somelist, Sint32 range, short *howmany, walker  *ob);
-		std::list<walker*> find_friends_in_range(std::list<walker*>& somelist, Sint32 range, short *howmany, walker  *ob);
+		// These fill result from the obmap and return how many; by_distance puts the nearest first
+		short find_in_range(walker  *ob, Sint32 range, Uint32 orders, std::vector<walker*>& result, bool by_distance = false);
+		short find_foes_in_range(walker  *ob, Sint32 range, std::vector<walker*>& result, bool by_distance = false);
+		short find_friends_in_range(walker  *ob, Sint32 range, std::vector<walker*>& result, bool by_distance = false);
 		std::list<walker*> find_foe_weapons_in_range(std::list<walker*>& somelist, Sint32 range, short *howmany, walker  *ob);
 		char damage_tile(short xloc, short yloc); // damage the specified tile
 		void do_notify(const char *message, walker  *who);  // printing text
@@ -82,6 +86,7 @@ class screen : public video
 		
 		// Level data
 		LevelData level_data;
+		std::vector<walker*> range_buffer;  // for find_*_in_range when only the count matters
 		
 		// Save data
 		SaveData save_data;
@@ -100,7 +105,7 @@ class screen : public video
 		unsigned short enemy_freeze; // stops enemies from acting
 		soundob *soundp;
 		short redrawme;
-		viewscreen  * viewob[5];
+		viewscreen  * viewob[MAX_VIEWS];
 		short numviews;
 		Uint32 timerstart;
 		Uint32 framecount;
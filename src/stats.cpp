@@ -85,7 +85,7 @@ void statistics::clear_command()
 	// Make sure we're back to our real team
 	if (controller->real_team_num != 255)
 	{
-		controller->team_num = controller->real_team_num;
+		controller->set_team(controller->real_team_num);
 		controller->real_team_num = 255;
 	}
 	controller->leader = NULL;
@@ -396,7 +396,7 @@ short statistics::do_command()
 			  }
 			  else if (controller->real_team_num != 255)
 			  {
-			    controller->team_num = controller->real_team_num;
+			    controller->set_team(controller->real_team_num);
 			    controller->real_team_num = 255;
 			  }
 			*/
@@ -509,8 +509,7 @@ void statistics::hit_response(walker  *who)
 					foe->foe = controller;
 					last_distance = current_distance = 15000;
 				}
-				myscreen->find_foes_in_range(myscreen->level_data.oblist,
-				                                       200, &howmany, controller);
+				howmany = myscreen->find_foes_in_range(controller, 200, myscreen->range_buffer);
                 
 				if (howmany) // foes within range?
 				{
@@ -604,15 +603,14 @@ void statistics::hit_response(walker  *who)
 
 void statistics::yell_for_help(walker *foe)
 {
-	short howmany;
 	Sint32 deltax, deltay;
 	char message[80];
 
 	controller->yo_delay += 80;
 	
 	// Get AI-controlled allies to target my foe
-	std::list<walker*> helplist = myscreen->find_friends_in_range(
-	               myscreen->level_data.oblist, 160, &howmany, controller);
+	std::vector<walker*> helplist;
+	myscreen->find_friends_in_range(controller, 160, helplist);
 	for(auto e = helplist.begin(); e != helplist.end(); e++)
 	{
 	    walker* w = *e;
@@ -1096,8 +1094,8 @@ bool statistics::walk_to_foe()
 		// Do simpler pathing if the distance is short or if there are too many walkers (pathfinding is expensive)
 		if (tempdistance < PATHING_MIN_DISTANCE || myscreen->level_data.myobmap->size() > PATHING_SHORT_CIRCUIT_OBJECT_LIMIT)
 		{
-			std::list<walker*> foelist = myscreen->find_foes_in_range(myscreen->level_data.oblist,
-			          PATHING_MIN_DISTANCE, &howmany, controller);
+			std::vector<walker*> foelist;
+			howmany = myscreen->find_foes_in_range(controller, PATHING_MIN_DISTANCE, foelist, true);
 			if (howmany > 0)
 			{
 			    walker* firstfoe = foelist.front();
@@ -15,12 +15,185 @@
  * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  */
 #include "graph.h"
+#include <list>
+#include <map>
+#include <string>
 
 void get_input_events(bool);
 
 static PixieData letters1;
 static PixieData letters_big;
 
+// Glyph atlases: a copy of a font with every glyph already recolored
+// for one color, compiled to spans, so a letter is a span copy instead
+// of a recolor test per pixel.  There are only a handful of text colors
+// in use at a time, so they are simply all dropped if that ever grows.
+#define MAX_GLYPH_ATLASES 64
+
+typedef std::pair<unsigned char*, int> GlyphAtlasKey;  // font data, color | shaded<<8
+static std::map<GlyphAtlasKey, PixieData> glyph_atlases;
+
+static unsigned char recolor_glyph_pixel(unsigned char c, unsigned char color, bool shaded)
+{
+    if(c <= 247)
+        return c;
+    if(shaded)
+        return (unsigned char) (color + (255 - c));
+    return color;
+}
+
+// Viewscreens may write text from several threads at once: both caches
+// are behind text_cache_lock, and while they are held (text::hold_caches)
+// nothing is thrown out that another thread could still be drawing.
+static SDL_SpinLock text_cache_lock = 0;
+static int text_caches_held = 0;
+
+static const PixieData& query_glyph_atlas(const PixieData& font, unsigned char color, bool shaded)
+{
+    GlyphAtlasKey key(font.data, color | (shaded << 8));
+    std::map<GlyphAtlasKey, PixieData>::iterator e = glyph_atlases.find(key);
+    if(e != glyph_atlases.end())
+        return e->second;
+    
+    if(glyph_atlases.size() >= MAX_GLYPH_ATLASES && !text_caches_held)
+    {
+        for(e = glyph_atlases.begin(); e != glyph_atlases.end(); e++)
+            e->second.free();
+        glyph_atlases.clear();
+    }
+    
+    int size = font.frames*font.w*font.h;
+    unsigned char* data = new unsigned char[size];
+    for(int i = 0; i < size; i++)
+        data[i] = recolor_glyph_pixel(font.data[i], color, shaded);
+    
+    PixieData& atlas = glyph_atlases[key];
+    atlas = PixieData(font.frames, font.w, font.h, data);
+    atlas.compile_spans(false);
+    return atlas;
+}
+
+// String cache: whole lines of text rendered once and kept as spans,
+// since the HUD writes the same few strings every frame.  Lines too
+// wide for a PixieData are drawn a glyph at a time instead.
+#define MAX_CACHED_STRINGS 64
+
+struct CachedString
+{
+    unsigned char* font;
+    unsigned char color;
+    bool shaded;
+    std::string text;
+    PixieData image;
+};
+
+static std::list<CachedString> string_cache;  // most recently used first
+
+static const PixieData* query_cached_string(const PixieData& font, const char* string, unsigned char color, bool shaded)
+{
+    size_t len = strlen(string);
+    if(len == 0 || len*(font.w+1) > 255)
+        return NULL;
+    
+    for(std::list<CachedString>::iterator e = string_cache.begin(); e != string_cache.end(); e++)
+    {
+        if(e->font == font.data && e->color == color && e->shaded == shaded && e->text == string)
+        {
+            if(e != string_cache.begin())
+                string_cache.splice(string_cache.begin(), string_cache, e);
+            return &string_cache.front().image;
+        }
+    }
+    
+    while(string_cache.size() >= MAX_CACHED_STRINGS && !text_caches_held)
+    {
+        string_cache.back().image.free();
+        string_cache.pop_back();
+    }
+    
+    int w = len*(font.w+1);
+    int h = font.h;
+    unsigned char* data = new unsigned char[w*h];
+    memset(data, 0, w*h);
+    for(size_t i = 0; i < len; i++)
+    {
+        int letter = string[i];
+        if(letter < 0 || letter >= font.frames)
+            continue;
+        unsigned char* glyph = &font.data[letter*font.w*font.h];
+        for(int y = 0; y < h; y++)
+            for(int x = 0; x < font.w; x++)
+                data[y*w + i*(font.w+1) + x] = recolor_glyph_pixel(glyph[y*font.w + x], color, shaded);
+    }
+    
+    CachedString entry;
+    entry.font = font.data;
+    entry.color = color;
+    entry.shaded = shaded;
+    entry.text = string;
+    entry.image = PixieData(1, w, h, data);
+    entry.image.compile_spans(false);
+    string_cache.push_front(entry);
+    return &string_cache.front().image;
+}
+
+void text::put_char(short x, short y, char letter, unsigned char color, bool shaded,
+                    short portstartx, short portstarty, short portendx, short portendy)
+{
+    if(letter < 0 || letter >= letters.frames)
+        return;
+    
+    SDL_AtomicLock(&text_cache_lock);
+    const PixieData& atlas = query_glyph_atlas(letters, color, shaded);
+    SDL_AtomicUnlock(&text_cache_lock);
+    myscreen->walkputspans(x, y, sizex, sizey, portstartx, portstarty, portendx, portendy,
+                           atlas.frame_spans(letter), 0);
+}
+
+// Monospaced, like the write_char_xy loops it replaces
+void text::put_string(short x, short y, const char *string, unsigned char color, bool shaded,
+                      short portstartx, short portstarty, short portendx, short portendy)
+{
+    SDL_AtomicLock(&text_cache_lock);
+    const PixieData* image = query_cached_string(letters, string, color, shaded);
+    SDL_AtomicUnlock(&text_cache_lock);
+    if(image)
+    {
+        myscreen->walkputspans(x, y, image->w, image->h, portstartx, portstarty, portendx, portendy,
+                               image->frame_spans(0), 0);
+        return;
+    }
+    
+    for(unsigned short i = 0; string[i]; i++)
+        put_char((short) (x+i*(sizex+1)), y, string[i], color, shaded,
+                 portstartx, portstarty, portendx, portendy);
+}
+
+void text::hold_caches()
+{
+    text_caches_held++;
+}
+
+void text::release_caches()
+{
+    if(--text_caches_held > 0)
+        return;
+    
+    SDL_AtomicLock(&text_cache_lock);
+    if(glyph_atlases.size() > MAX_GLYPH_ATLASES)
+    {
+        for(std::map<GlyphAtlasKey, PixieData>::iterator e = glyph_atlases.begin(); e != glyph_atlases.end(); e++)
+            e->second.free();
+        glyph_atlases.clear();
+    }
+    while(string_cache.size() > MAX_CACHED_STRINGS)
+    {
+        string_cache.back().image.free();
+        string_cache.pop_back();
+    }
+    SDL_AtomicUnlock(&text_cache_lock);
+}
+
 
 text::text(const char * filename)
     : sizex(0), sizey(0)
@@ -70,12 +243,7 @@ short text::query_width(const char *string) // returns width, in pixels
 
 short text::write_xy(short x, short y, const char *string, unsigned char color)
 {
-	unsigned short i = 0;
-	while(string[i])
-	{
-		write_char_xy((short) (x+i*(sizex+1)), y, string[i], (unsigned char) color);
-		i++;
-	}
+	put_string(x, y, string, color, false, 0, 0, 320, 200);
 	return 1;
 }
 
@@ -90,13 +258,8 @@ short text::write_xy(short x, short y, unsigned char color, const char* formatte
     vsnprintf(text_buffer, 255, formatted_string, lst);
     va_end(lst);
     
-	unsigned short i = 0;
-	while(text_buffer[i])
-	{
-		write_char_xy((short) (x+i*(sizex+1)), y, text_buffer[i], (unsigned char) color);
-		i++;
-	}
-	return i*(sizex+1);
+	put_string(x, y, text_buffer, color, false, 0, 0, 320, 200);
+	return strlen(text_buffer)*(sizex+1);
 }
 
 short text::write_xy_shadow(short x, short y, unsigned char color, const char* formatted_string, ...)
@@ -109,15 +272,10 @@ short text::write_xy_shadow(short x, short y, unsigned char color, const char* f
     vsnprintf(text_buffer, 255, formatted_string, lst);
     va_end(lst);
     
-	unsigned short i = 0;
-	while(text_buffer[i])
-	{
-	    short xx = (x+i*(sizex+1));
-		write_char_xy(xx - 1, y + 1, text_buffer[i], (unsigned char) (PURE_BLACK + 2));
-		write_char_xy(xx, y, text_buffer[i], (unsigned char) color);
-		i++;
-	}
-	return i*(sizex+1);
+	// the shadow never reaches into the next letter, so it can go first
+	put_string(x - 1, y + 1, text_buffer, (unsigned char) (PURE_BLACK + 2), false, 0, 0, 320, 200);
+	put_string(x, y, text_buffer, color, false, 0, 0, 320, 200);
+	return strlen(text_buffer)*(sizex+1);
 }
 
 short text::write_xy_center(short x, short y, unsigned char color, const char* formatted_string, ...)
@@ -130,13 +288,8 @@ short text::write_xy_center(short x, short y, unsigned char color, const char* f
     vsnprintf(text_buffer, 255, formatted_string, lst);
     va_end(lst);
     
-	unsigned short i = 0;
 	size_t len = strlen(text_buffer);
-	while(text_buffer[i])
-	{
-		write_char_xy((short) (x+i*(sizex+1) - len*(sizex+1)/2), y, text_buffer[i], (unsigned char) color);
-		i++;
-	}
+	put_string((short) (x - len*(sizex+1)/2), y, text_buffer, color, false, 0, 0, 320, 200);
 	return 1;
 }
 
@@ -160,36 +313,53 @@ short text::write_xy_center_alpha(short x, short y, unsigned char color, Uint8 a
 	return 1;
 }
 
-short text::write_xy_center_shadow(short x, short y, unsigned char color, const char* formatted_string, ...)
+// Clipped to the viewscreen, and with its own buffer since viewscreens
+// may be drawing at the same time
+short text::write_xy_center_alpha(short x, short y, unsigned char color, Uint8 alpha, viewscreen *whereto, const char* formatted_string, ...)
 {
     if(formatted_string == NULL)
         return 0;
     
+    char buffer[255];
     va_list lst;
     va_start(lst, formatted_string);
-    vsnprintf(text_buffer, 255, formatted_string, lst);
+    vsnprintf(buffer, 255, formatted_string, lst);
     va_end(lst);
     
 	unsigned short i = 0;
-	size_t len = strlen(text_buffer);
-	while(text_buffer[i])
+	size_t len = strlen(buffer);
+	x = (short) (x + whereto->xloc - len*(sizex+1)/2);
+	y = (short) (y + whereto->yloc);
+	while(buffer[i])
 	{
-	    short xx = (x+i*(sizex+1) - len*(sizex+1)/2);
-		write_char_xy(xx - 1, y + 1, text_buffer[i], (unsigned char) (PURE_BLACK + 2));
-		write_char_xy(xx, y, text_buffer[i], (unsigned char) color);
+		myscreen->walkputbuffertext_alpha(x+i*(sizex+1), y, sizex, sizey,
+		                                  whereto->xloc, whereto->yloc, whereto->endx, whereto->endy,
+		                                  &letters.data[buffer[i] * sizex * sizey], color, alpha);
 		i++;
 	}
 	return 1;
 }
 
+short text::write_xy_center_shadow(short x, short y, unsigned char color, const char* formatted_string, ...)
+{
+    if(formatted_string == NULL)
+        return 0;
+    
+    va_list lst;
+    va_start(lst, formatted_string);
+    vsnprintf(text_buffer, 255, formatted_string, lst);
+    va_end(lst);
+    
+	size_t len = strlen(text_buffer);
+	short xx = (short) (x - len*(sizex+1)/2);
+	put_string(xx - 1, y + 1, text_buffer, (unsigned char) (PURE_BLACK + 2), false, 0, 0, 320, 200);
+	put_string(xx, y, text_buffer, color, false, 0, 0, 320, 200);
+	return 1;
+}
+
 short text::write_xy(short x, short y, const char *string)
 {
-	unsigned short i = 0;
-	while(string[i])
-	{
-		write_char_xy((short) (x+i*(sizex+1)), y, string[i], (unsigned char) DEFAULT_TEXT_COLOR);
-		i++;
-	}
+	put_string(x, y, string, DEFAULT_TEXT_COLOR, false, 0, 0, 320, 200);
 	return 1;
 }
 
@@ -201,19 +371,17 @@ short text::write_xy(short x, short y, const char *string, unsigned char color,
 	short over = 0;
 
 	if (sizex < 9) // small, monospaced font
-		while(string[i])
-		{
-			if (!to_buffer)
-				write_char_xy((short) (x+i*(sizex+1)), y, string[i], (unsigned char) color);
-			else
-				write_char_xy((short) (x+i*(sizex+1)), y, string[i], (unsigned char) color, (short) 1);
-			i++;
-			over += sizex+1;
-		}
+	{
+		if (!to_buffer)
+			put_string(x, y, string, color, false, 0, 0, 320, 200);
+		else
+			put_string(x, y, string, color, true, 0, 0, 319, 199);
+		over = (short) (strlen(string)*(sizex+1));
+	}
 	else // larger font, help out the lowercase ..
 		while(string[i])
 		{
-			write_char_xy((short) (x+over), y, string[i], (unsigned char) color, (short) 1);
+			put_char((short) (x+over), y, string[i], color, true, 0, 0, 319, 199);
 			if (string[i] >=65 && string[i] <= 92) // uppercase
 				over += sizex;
 			else // lowercase, other things
@@ -234,16 +402,11 @@ short text::write_xy(short x, short y, const char *string, unsigned char color,
 
 short text::write_xy(short x, short y, const char *string, short to_buffer)
 {
-	unsigned short i = 0;
 	unsigned short width;
-	while(string[i])
-	{
-		if (!to_buffer)
-			write_char_xy((short) (x+i*(sizex+1)), y, string[i], (unsigned char) DEFAULT_TEXT_COLOR);
-		else
-			write_char_xy((short) (x+i*(sizex+1)), y, string[i], (unsigned char) DEFAULT_TEXT_COLOR, (short) 1);
-		i++;
-	}
+	if (!to_buffer)
+		put_string(x, y, string, DEFAULT_TEXT_COLOR, false, 0, 0, 320, 200);
+	else
+		put_string(x, y, string, DEFAULT_TEXT_COLOR, true, 0, 0, 319, 199);
 	if (to_buffer)
 	{
 		width = (unsigned short) ((sizex+1)*strlen(string));
@@ -258,29 +421,21 @@ short text::write_xy(short x, short y, const char *string, short to_buffer)
 short text::write_xy(short x, short y, const char *string, unsigned char color,
                      viewscreen *whereto)
 {
-	unsigned short i = 0;
-	while(string[i])
-	{
-		if (!whereto)
-			write_char_xy((short) (x+i*(sizex+1)), y, string[i], (unsigned char) color);
-		else
-			write_char_xy((short) (x+i*(sizex+1)), y, string[i], (unsigned char) color, whereto);
-		i++;
-	}
+	if (!whereto)
+		put_string(x, y, string, color, false, 0, 0, 320, 200);
+	else
+		put_string(x+whereto->xloc, y+whereto->yloc, string, color, true,
+		           whereto->xloc, whereto->yloc, whereto->endx, whereto->endy);
 	return 1;
 }
 
 short text::write_xy(short x, short y, const char *string, viewscreen *whereto)
 {
-	unsigned short i = 0;
-	while(string[i])
-	{
-		if (!whereto)
-			write_char_xy((short) (x+i*(sizex+1)), y, string[i], (unsigned char) DEFAULT_TEXT_COLOR);
-		else
-			write_char_xy((short) (x+i*(sizex+1)), y, string[i], (unsigned char) DEFAULT_TEXT_COLOR, whereto);
-		i++;
-	}
+	if (!whereto)
+		put_string(x, y, string, DEFAULT_TEXT_COLOR, false, 0, 0, 320, 200);
+	else
+		put_string(x+whereto->xloc, y+whereto->yloc, string, DEFAULT_TEXT_COLOR, true,
+		           whereto->xloc, whereto->yloc, whereto->endx, whereto->endy);
 	return 1;
 }
 
@@ -360,7 +515,7 @@ short text::write_char_xy(short x, short y, char letter, unsigned char color,
 	if (!to_buffer)
 		return write_char_xy(x, y, letter, (unsigned char) color);
 
-	myscreen->walkputbuffertext(x, y, sizex, sizey, 0, 0, 319,199, &letters.data[letter * sizex * sizey], (unsigned char) color);
+	put_char(x, y, letter, color, true, 0, 0, 319, 199);
 	//myscreen->buffer_to_screen(x, y, sizex + 4 - (sizex%4), sizey + 4 - (sizey%4) );
 	return 1;
 }
@@ -370,14 +525,14 @@ short text::write_char_xy(short x, short y, char letter, short to_buffer)
 	if (!to_buffer)
 		return write_char_xy(x, y, letter, (unsigned char) DEFAULT_TEXT_COLOR);
 
-	myscreen->walkputbuffertext(x, y, sizex, sizey, 0, 0, 319,199, &letters.data[letter * sizex * sizey], (unsigned char) DEFAULT_TEXT_COLOR);
+	put_char(x, y, letter, DEFAULT_TEXT_COLOR, true, 0, 0, 319, 199);
 	//myscreen->buffer_to_screen(x, y, sizex + 4 - (sizex%4), sizey + 4 - (sizey%4) );
 	return 1;
 }
 
 short text::write_char_xy(short x, short y, char letter, unsigned char color)
 {
-	myscreen->putdatatext(x, y, sizex, sizey, &letters.data[letter *sizex*sizey], (unsigned char) color);
+	put_char(x, y, letter, color, false, 0, 0, 320, 200);
 	return 1;
 }
 
@@ -397,11 +552,10 @@ short text::write_char_xy(short x, short y, char letter, unsigned char color,
                           viewscreen *whereto)
 {
 	if (!whereto)
-		myscreen->putdatatext(x, y, sizex, sizey, &letters.data[letter *sizex*sizey], (unsigned char) color);
+		put_char(x, y, letter, color, false, 0, 0, 320, 200);
 	else
-		myscreen->walkputbuffertext(x+whereto->xloc, y+whereto->yloc, sizex, sizey,
-		                       whereto->xloc,whereto->yloc,whereto->endx, whereto->endy,
-		                       &letters.data[letter *sizex*sizey], (unsigned char) color);
+		put_char(x+whereto->xloc, y+whereto->yloc, letter, color, true,
+		         whereto->xloc, whereto->yloc, whereto->endx, whereto->endy);
 	//         myscreen->buffer_to_screen(x+whereto->xloc, y+whereto->yloc,
 	//           (sizex + 4 - (sizex%4)), (sizey + 4 - (sizey%4)) );
 	return 1;
@@ -412,9 +566,8 @@ short text::write_char_xy(short x, short y, char letter, viewscreen *whereto)
 	if (!whereto)
 		myscreen->putdatatext(x, y, sizex, sizey, &letters.data[letter *sizex*sizey]);
 	else
-		myscreen->walkputbuffertext(x+whereto->xloc, y+whereto->yloc, sizex, sizey,
-		                       whereto->xloc,whereto->yloc,whereto->endx, whereto->endy,
-		                       &letters.data[letter *sizex*sizey], (unsigned char) DEFAULT_TEXT_COLOR);
+		put_char(x+whereto->xloc, y+whereto->yloc, letter, DEFAULT_TEXT_COLOR, true,
+		         whereto->xloc, whereto->yloc, whereto->endx, whereto->endy);
 	//         myscreen->buffer_to_screen(x+whereto->xloc, y+whereto->yloc,
 	//           (sizex + 4 - (sizex%4)), (sizey + 4 - (sizey%4)) );
 	return 1;
@@ -37,6 +37,7 @@ class text
 		short write_xy_shadow(short x, short y, unsigned char color, const char* formatted_string, ...);
 		short write_xy_center(short x, short y, unsigned char color, const char* formatted_string, ...);
 		short write_xy_center_alpha(short x, short y, unsigned char color, Uint8 alpha, const char* formatted_string, ...);
+		short write_xy_center_alpha(short x, short y, unsigned char color, Uint8 alpha, viewscreen *whereto, const char* formatted_string, ...);
 		short write_xy_center_shadow(short x, short y, unsigned char color, const char* formatted_string, ...);
 		short write_xy(short x, short y, const char  *string, short to_buffer);
 		short write_xy(short x, short y, const char  *string, unsigned char color, short to_buffer);
@@ -65,6 +66,20 @@ class text
 
 	    PixieData letters;
 	    short sizex, sizey;
+
+		// Keep cached glyphs and strings alive until released, so
+		// several viewscreens can write at once
+		static void hold_caches();
+		static void release_caches();
+
+	protected:
+		// Draw from the recolored glyph atlas and string cache.  shaded
+		// keeps the gradient walkputbuffertext gives the font, otherwise
+		// the whole glyph is the flat color, like putdatatext.
+		void put_string(short x, short y, const char *string, unsigned char color, bool shaded,
+		                short portstartx, short portstarty, short portendx, short portendy);
+		void put_char(short x, short y, char letter, unsigned char color, bool shaded,
+		              short portstartx, short portstarty, short portendx, short portendy);
 };
 
 #endif
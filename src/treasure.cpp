@@ -310,6 +310,7 @@ void treasure::set_direct_frame(short whatframe)
 
 	data = myscreen->level_data.myloader->graphics[PIX(order, family)];
 	bmp = data.data + frame*size;
+	bmp_spans = data.frame_spans(frame);
 
 }
 
@@ -26,11 +26,29 @@
 #define CY_SCREEN 200
 #define ASSERT(x) if (!(x)) return 0;
 
+int toInt(const std::string& s);
+
 
 unsigned char * videoptr = (unsigned char*) VIDEO_LINEAR;
 
+// Alpha blending on rows of palette indices, through the tables from
+// query_blend_table.  fill is one row of a table: a constant color.
+static inline void blend_fill_row(unsigned char *dest, Sint32 length, const unsigned char *fill)
+{
+	for (Sint32 i = 0; i < length; i++)
+		dest[i] = fill[dest[i]];
+}
+
+static inline void blend_row(unsigned char *dest, const unsigned char *source, Sint32 length, const unsigned char *table)
+{
+	for (Sint32 i = 0; i < length; i++)
+		dest[i] = table[source[i]*256 + dest[i]];
+}
+
 Screen *E_Screen;
 
+static void stop_capture_thread();
+
 video::video()
     : text_normal(TEXT_1), text_big(TEXT_BIG)
 {
@@ -53,8 +71,26 @@ video::video()
 		render = EAGLE;
 	else if(qresult == "double")
 		render = DOUBLE;
+	else if(qresult == "nearest2x")
+		render = NEAREST2X;
+	else if(qresult == "nearest3x")
+		render = NEAREST3X;
+	else if(qresult == "nearest4x")
+		render = NEAREST4X;
+	else if(qresult == "scale2x")
+		render = SCALE2X;
+	else if(qresult == "scale3x")
+		render = SCALE3X;
+	else if(qresult == "headless")
+		render = HEADLESS;
 	
 	fadeDuration = 500;
+	
+	recording = false;
+	record_every = 1;
+	record_count = 0;
+	record_frames = 0;
+	record_take = 0;
 
 	// Load our palettes ..
 	load_and_set_palette("our.pal", ourpalette);
@@ -76,11 +112,17 @@ video::video()
 	//	bluepalette[i*3+1] /= 2;
 	//}
 	
-	E_Screen = new Screen(render, 640, 400, fullscreen);
+	// Size the window so the integer engines show at exactly their scale
+	int scale = query_engine_scale(render);
+	if(scale < 2)
+		scale = 2;
+	E_Screen = new Screen(render, 320*scale, 200*scale, fullscreen);
+	videobuffer = E_Screen->framebuffer;
 }
 
 video::~video()
 {
+	stop_capture_thread();
 	delete E_Screen;
 	SDL_Quit();
 }
@@ -107,7 +149,7 @@ void video::set_fullscreen(bool fullscreen)
 
 unsigned char * video::getbuffer()
 {
-	return &videobuffer[0];
+	return videobuffer;
 }
 
 void video::clearbuffer()
@@ -167,8 +209,20 @@ void video::draw_box(Sint32 x1, Sint32 y1, Sint32 x2, Sint32 y2, unsigned char c
 
 void video::draw_rect_filled(Sint32 x, Sint32 y, Uint32 w, Uint32 h, unsigned char color, Uint8 alpha)
 {
-    for (Uint32 i = 0; i < h; i++)
-        hor_line_alpha(x, y+i, w, color, alpha);
+    Sint32 x2 = x + (Sint32)w, y2 = y + (Sint32)h;
+    const unsigned char *fill;
+
+    if (x < 0) x = 0;
+    if (y < 0) y = 0;
+    if (x2 > CX_SCREEN) x2 = CX_SCREEN;
+    if (y2 > CY_SCREEN) y2 = CY_SCREEN;
+    if (x2 <= x || y2 <= y)
+        return;
+
+    fill = query_blend_table(alpha) + color*256;
+    for (Sint32 i = y; i < y2; i++)
+        blend_fill_row(&videobuffer[i*VIDEO_BUFFER_WIDTH + x], x2 - x, fill);
+    E_Screen->mark_dirty(x, y, x2 - x, y2 - y);
 }
 
 
@@ -298,13 +352,8 @@ void video::draw_text_bar(Sint32 x1, Sint32 y1, Sint32 x2, Sint32 y2)
 
 void video::darken_screen()
 {
-    for(int i = 0; i < 320; i++)
-    {
-        for(int j = 0; j < 200; j++)
-        {
-            pointb(i, j, PURE_BLACK, 100);
-        }
-    }
+    blend_fill_row(videobuffer, VIDEO_SIZE, query_blend_table(100) + PURE_BLACK*256);
+    E_Screen->mark_dirty(0, 0, CX_SCREEN, CY_SCREEN);
 }
 
 
@@ -314,13 +363,14 @@ void video::putblack(Sint32 startx, Sint32 starty, Sint32 xsize, Sint32 ysize)
 	Sint32 curx, cury;
 	Sint32 curpoint;
 
+	E_Screen->mark_dirty(startx, starty, xsize, ysize);
 	for(cury = starty;cury < starty +ysize;cury++)
 	{
 		for (curx = startx; curx < startx +xsize; curx++)
 		{
 			curpoint = (curx + (cury*VIDEO_WIDTH));
 			if (curpoint > 0 && curpoint < VIDEO_SIZE)
-				videoptr[curpoint] = 0;
+				videobuffer[curpoint] = 0;
 		}
 	}
 }
@@ -335,19 +385,10 @@ void video::fastbox(Sint32 startx, Sint32 starty, Sint32 xsize, Sint32 ysize, un
 	fastbox(startx,starty,xsize,ysize,color,1);
 }
 
-Uint32 get_Uint32_color(unsigned char color)
-{
-    int r,g,b;
-	query_palette_reg(color,&r,&g,&b);
-	
-	return SDL_MapRGB(E_Screen->render->format, r*4, g*4, b*4);
-}
-
 // This is the version which writes to the buffer..
 void video::fastbox(Sint32 startx, Sint32 starty, Sint32 xsize, Sint32 ysize, unsigned char color, unsigned char flag)
 {
-	SDL_Rect rect;
-	int r,g,b;
+	Sint32 cury;
 
 	// Zardus: FIX: small check to make sure we're not trying to put in antimatter or something
 	if (xsize < 0 || ysize < 0 || startx < 0 || starty < 0)
@@ -359,14 +400,16 @@ void video::fastbox(Sint32 startx, Sint32 starty, Sint32 xsize, Sint32 ysize, un
 		return ;
 	}
 
-	//buffers: create the rect to fill with SDL_FillRect
-	rect.x = startx;
-	rect.y = starty;
-	rect.w = xsize;
-	rect.h = ysize;
+	if (startx + xsize > CX_SCREEN)
+		xsize = CX_SCREEN - startx;
+	if (starty + ysize > CY_SCREEN)
+		ysize = CY_SCREEN - starty;
+	if (xsize <= 0 || ysize <= 0)
+		return;
 
-	query_palette_reg(color,&r,&g,&b);
-	SDL_FillRect(E_Screen->render, &rect, SDL_MapRGB(E_Screen->render->format,r*4,g*4,b*4));
+	for (cury = starty; cury < starty + ysize; cury++)
+		memset(&videobuffer[cury*VIDEO_BUFFER_WIDTH + startx], color, xsize);
+	E_Screen->mark_dirty(startx, starty, xsize, ysize);
 }
 
 void video::fastbox_outline(Sint32 startx, Sint32 starty, Sint32 xsize, Sint32 ysize, unsigned char color)
@@ -382,202 +425,46 @@ void video::point(Sint32 x, Sint32 y, unsigned char color)
 	//buffers: PORT: SDL_UpdateRect(screen,x,y,1,1);
 }
 
-void putpixel(SDL_Surface *surface, int x, int y, Uint32 pixel)
-{
-    if(x < 0 || y < 0 || x >= surface->w || y >= surface->h)
-        return;
-    
-    int bpp = surface->format->BytesPerPixel;
-    /* Here p is the address to the pixel we want to set */
-    Uint8 *p = (Uint8 *)surface->pixels + y * surface->pitch + x * bpp;
-
-    switch(bpp) {
-    case 1:
-        *p = pixel;
-        break;
-
-    case 2:
-        *(Uint16 *)p = pixel;
-        break;
-
-    case 3:
-        if(SDL_BYTEORDER == SDL_BIG_ENDIAN) {
-            p[0] = (pixel >> 16) & 0xff;
-            p[1] = (pixel >> 8) & 0xff;
-            p[2] = pixel & 0xff;
-        } else {
-            p[0] = pixel & 0xff;
-            p[1] = (pixel >> 8) & 0xff;
-            p[2] = (pixel >> 16) & 0xff;
-        }
-        break;
-
-    case 4:
-        *(Uint32 *)p = pixel;
-        break;
-    }
-}
-
 //buffers: PORT: this draws a point in the offscreen buffer
 //buffers: PORT: used for all the funcs that draw stuff in the offscreen buf
 void video::pointb(Sint32 x, Sint32 y, unsigned char color)
 {
-	int r,g,b;
-	int c;
-
 	//buffers: this does bound checking (just to be safe)
 	if(x<0 || x>319 || y<0 || y>199)
 		return;
 
-	query_palette_reg(color,&r,&g,&b);
-
-	c = SDL_MapRGB(E_Screen->render->format, r*4, g*4, b*4);
-
-    putpixel(E_Screen->render, x, y, c);
-}
-
-void blend_pixel(SDL_Surface* surface, int x, int y, Uint32 color, Uint8 alpha)
-{
-    Uint32 Rmask = surface->format->Rmask, Gmask = surface->format->Gmask, Bmask = surface->format->Bmask, Amask = surface->format->Amask;
-    Uint32 R,G,B,A=0;//SDL_ALPHA_OPAQUE;
-    Uint32* pixel;
-    switch (surface->format->BytesPerPixel)
-    {
-        case 1: { /* Assuming 8-bpp */
-            
-                Uint8 *pixel = (Uint8 *)surface->pixels + y*surface->pitch + x;
-                
-                Uint8 dR = surface->format->palette->colors[*pixel].r;
-                Uint8 dG = surface->format->palette->colors[*pixel].g;
-                Uint8 dB = surface->format->palette->colors[*pixel].b;
-                Uint8 sR = surface->format->palette->colors[color].r;
-                Uint8 sG = surface->format->palette->colors[color].g;
-                Uint8 sB = surface->format->palette->colors[color].b;
-                
-                dR = dR + ((sR-dR)*alpha >> 8);
-                dG = dG + ((sG-dG)*alpha >> 8);
-                dB = dB + ((sB-dB)*alpha >> 8);
-            
-                *pixel = SDL_MapRGB(surface->format, dR, dG, dB);
-                
-        }
-        break;
-
-        case 2: { /* Probably 15-bpp or 16-bpp */		
-            
-                Uint16 *pixel = (Uint16 *)surface->pixels + y*surface->pitch/2 + x;
-                Uint32 dc = *pixel;
-            
-                R = ((dc & Rmask) + (( (color & Rmask) - (dc & Rmask) ) * alpha >> 8)) & Rmask;
-                G = ((dc & Gmask) + (( (color & Gmask) - (dc & Gmask) ) * alpha >> 8)) & Gmask;
-                B = ((dc & Bmask) + (( (color & Bmask) - (dc & Bmask) ) * alpha >> 8)) & Bmask;
-                if( Amask )
-                    A = ((dc & Amask) + (( (color & Amask) - (dc & Amask) ) * alpha >> 8)) & Amask;
-
-                *pixel= R | G | B | A;
-                
-        }
-        break;
-
-        case 3: { /* Slow 24-bpp mode, usually not used */
-            Uint8 *pix = (Uint8 *)surface->pixels + y * surface->pitch + x*3;
-            Uint8 rshift8=surface->format->Rshift/8;
-            Uint8 gshift8=surface->format->Gshift/8;
-            Uint8 bshift8=surface->format->Bshift/8;
-            Uint8 ashift8=surface->format->Ashift/8;
-            
-            
-            
-                Uint8 dR, dG, dB, dA=0;
-                Uint8 sR, sG, sB, sA=0;
-                
-                pix = (Uint8 *)surface->pixels + y * surface->pitch + x*3;
-                
-                dR = *((pix)+rshift8); 
-                dG = *((pix)+gshift8);
-                dB = *((pix)+bshift8);
-                dA = *((pix)+ashift8);
-                
-                sR = (color>>surface->format->Rshift)&0xff;
-                sG = (color>>surface->format->Gshift)&0xff;
-                sB = (color>>surface->format->Bshift)&0xff;
-                sA = (color>>surface->format->Ashift)&0xff;
-                
-                dR = dR + ((sR-dR)*alpha >> 8);
-                dG = dG + ((sG-dG)*alpha >> 8);
-                dB = dB + ((sB-dB)*alpha >> 8);
-                dA = dA + ((sA-dA)*alpha >> 8);
-
-                *((pix)+rshift8) = dR; 
-                *((pix)+gshift8) = dG;
-                *((pix)+bshift8) = dB;
-                *((pix)+ashift8) = dA;
-                
-        }
-        break;
-
-        case 4: /* Probably 32-bpp */
-            pixel = (Uint32*)surface->pixels + y*surface->pitch/4 + x;
-            Uint32 dc = *pixel;
-            R = color & Rmask;
-            G = color & Gmask;
-            B = color & Bmask;
-            A = 0;  // keep this as 0 to avoid corruption of non-alpha surfaces
-            
-            // Blend and keep dest alpha
-            if( alpha != SDL_ALPHA_OPAQUE )
-            {
-                R = ((dc & Rmask) + (( R - (dc & Rmask) ) * alpha >> 8)) & Rmask;
-                G = ((dc & Gmask) + (( G - (dc & Gmask) ) * alpha >> 8)) & Gmask;
-                B = ((dc & Bmask) + (( B - (dc & Bmask) ) * alpha >> 8)) & Bmask;
-            }
-            if(Amask)
-                A = (dc & Amask);
-            
-            *pixel = R | G | B | A;
-        break;
-    }
+	videobuffer[y*VIDEO_BUFFER_WIDTH + x] = color;
+	E_Screen->mark_dirty(x, y, 1, 1);
 }
 
 void video::pointb(Sint32 x, Sint32 y, unsigned char color, unsigned char alpha)
 {
-	int r,g,b;
-	int c;
+	unsigned char *pixel;
 
 	//buffers: this does bound checking (just to be safe)
 	if(x<0 || x>319 || y<0 || y>199)
 		return;
 
-	query_palette_reg(color,&r,&g,&b);
-
-	c = SDL_MapRGB(E_Screen->render->format, r*4, g*4, b*4);
-	
-    blend_pixel(E_Screen->render, x, y, c, alpha);
+	pixel = &videobuffer[y*VIDEO_BUFFER_WIDTH + x];
+	*pixel = blend_palette_index(*pixel, color, alpha);
+	E_Screen->mark_dirty(x, y, 1, 1);
 }
 
 //buffers: this sets the color using raw RGB values. no *4...
+// The framebuffer is indexed, so this picks the closest palette color.
 void video::pointb(Sint32 x, Sint32 y, int r, int g, int b)
 {
-	SDL_Rect  rect;
-	int c;
-	c = SDL_MapRGB(E_Screen->render->format,r,g,b);
-
-	rect.x = x;
-	rect.y = y;
-	rect.w = 1;
-	rect.h = 1;
-	SDL_FillRect(E_Screen->render,&rect,c);
+	pointb(x, y, nearest_palette_index(r/4, g/4, b/4));
 }
 
 //buffers: draw color using an offset
 void video::pointb(int offset, unsigned char color)
 {
-	int x, y;
-
-	y = offset/320;
-	x = offset - y*320;
+	if (offset < 0 || offset >= VIDEO_SIZE)
+		return;
 
-	pointb(x,y,color);
+	videobuffer[offset] = color;
+	E_Screen->mark_dirty(offset % VIDEO_BUFFER_WIDTH, offset / VIDEO_BUFFER_WIDTH, 1, 1);
 }
 
 // Place a horizontal line on the screen.
@@ -597,16 +484,28 @@ void video::hor_line(Sint32 x, Sint32 y, Sint32 length, unsigned char color, Sin
 		return;
 	}
 	
+	E_Screen->mark_dirty(x, y, length, 1);
 	for (i = 0; i < length; i++)
 		pointb(x+i,y,color);
 }
 
 void video::hor_line_alpha(Sint32 x, Sint32 y, Sint32 length, unsigned char color, Uint8 alpha)
 {
-	Sint32 i;
+	if (y < 0 || y >= CY_SCREEN)
+		return;
+	if (x < 0)
+	{
+		length += x;
+		x = 0;
+	}
+	if (x + length > CX_SCREEN)
+		length = CX_SCREEN - x;
+	if (length <= 0)
+		return;
 
-	for (i = 0; i < length; i++)
-		pointb(x+i,y,color, alpha);
+	E_Screen->mark_dirty(x, y, length, 1);
+	blend_fill_row(&videobuffer[y*VIDEO_BUFFER_WIDTH + x], length,
+	               query_blend_table(alpha) + color*256);
 }
 
 
@@ -628,6 +527,7 @@ void video::ver_line(Sint32 x, Sint32 y, Sint32 length, unsigned char color, Sin
 		return;
 	}
 	
+	E_Screen->mark_dirty(x, y, 1, length);
 	for (i = 0; i < length; i++)
 		pointb(x,y+i,color);
 }
@@ -645,7 +545,6 @@ void video::draw_line(Sint32 x1, Sint32 y1, Sint32 x2, Sint32 y2, unsigned char
     if((x1 >= Surface->w && x2 >= Surface->w) || (y1 >= Surface->h && y2 >= Surface->h))
         return;
     
-    Uint32 Color = get_Uint32_color(color);
     Sint16 dx, dy, sdx, sdy, x, y, px, py;
 
     dx = x2 - x1;
@@ -662,11 +561,13 @@ void video::draw_line(Sint32 x1, Sint32 y1, Sint32 x2, Sint32 y2, unsigned char
     px = x1;
     py = y1;
 
+    E_Screen->mark_dirty((x1 < x2) ? x1 : x2, (y1 < y2) ? y1 : y2, dx, dy);
+
     if (dx >= dy)
     {
         for (x = 0; x < dx; x++)
         {
-            putpixel(Surface, px, py, Color);
+            pointb(px, py, color);
 
             y += dy;
             if (y >= dx)
@@ -681,7 +582,7 @@ void video::draw_line(Sint32 x1, Sint32 y1, Sint32 x2, Sint32 y2, unsigned char
     {
         for (y = 0; y < dy; y++)
         {
-            putpixel(Surface, px, py, Color);
+            pointb(px, py, color);
 
             x += dx;
             if (x >= dy)
@@ -697,40 +598,16 @@ void video::draw_line(Sint32 x1, Sint32 y1, Sint32 x2, Sint32 y2, unsigned char
 //
 //video::do_cycle
 //cycle the palette for flame and water motion
-// query and set functions are located in pal32.cpp
-//buffers: PORT: added & to the last 3 args of the query_palette_reg funcs
+// The rotation is done on the palette registers and their native
+// lookup, so the framebuffer itself is never touched.
 void video::do_cycle(Sint32 curmode, Sint32 maxmode)
 {
-	Sint32 i;
-	//buffers: PORT: changed these two arrays to ints
-	int tempcol[3];
-	int curcol[3];
-
 	curmode %= maxmode;   // avoid over-runs
 
 	if (!curmode)  // then cycle on 0
 	{
-		// For orange:
-		query_palette_reg(ORANGE_END, &tempcol[0],
-		                  &tempcol[1], &tempcol[2]);        // get first color
-		for (i=ORANGE_END; i > ORANGE_START; i--)
-		{
-			query_palette_reg((char) (i-1), &curcol[0], &curcol[1], &curcol[2]);
-			set_palette_reg((char) i, (char) curcol[0],(char) curcol[1], (char) curcol[2]);
-		}
-		set_palette_reg(ORANGE_START, tempcol[0],
-		                tempcol[1], tempcol[2]);        // reassign last to first
-
-		// For blue:
-		query_palette_reg(WATER_END, &tempcol[0],
-		                  &tempcol[1], &tempcol[2]);        // get first color
-		for (i=WATER_END; i > WATER_START; i--)
-		{
-			query_palette_reg((char) (i-1), &curcol[0], &curcol[1], &curcol[2]);
-			set_palette_reg((char) i, curcol[0], curcol[1], curcol[2]);
-		}
-		set_palette_reg(WATER_START, tempcol[0],
-		                tempcol[1], tempcol[2]);        // reassign last to first
+		rotate_palette_regs(ORANGE_START, ORANGE_END);
+		rotate_palette_regs(WATER_START, WATER_END);
 	}
 }
 
@@ -743,6 +620,7 @@ void video::putdata(Sint32 startx, Sint32 starty, Sint32 xsize, Sint32 ysize, un
 	unsigned char curcolor;
 	Uint32 num = 0;
 
+	E_Screen->mark_dirty(startx, starty, xsize, ysize);
 	for(cury = starty;cury < starty +ysize;cury++)
 		for (curx = startx; curx < startx +xsize; curx++)
 		{
@@ -762,15 +640,17 @@ void video::putdata_alpha(Sint32 startx, Sint32 starty, Sint32 xsize, Sint32 ysi
 	Sint32 curx, cury;
 	unsigned char curcolor;
 	Uint32 num = 0;
+	const unsigned char *table = query_blend_table(alpha);
 
+	E_Screen->mark_dirty(startx, starty, xsize, ysize);
 	for(cury = starty;cury < starty +ysize;cury++)
 		for (curx = startx; curx < startx +xsize; curx++)
 		{
 			curcolor = sourcedata[num++];
-			if (!curcolor)
+			if (!curcolor || curx < 0 || curx >= CX_SCREEN || cury < 0 || cury >= CY_SCREEN)
 				continue;
             
-			pointb(curx,cury,curcolor, alpha);
+			videobuffer[cury*VIDEO_BUFFER_WIDTH + curx] = table[curcolor*256 + videobuffer[cury*VIDEO_BUFFER_WIDTH + curx]];
 		}
 }
 
@@ -780,9 +660,8 @@ void video::putdatatext(Sint32 startx, Sint32 starty, Sint32 xsize, Sint32 ysize
         Sint32 curx, cury;
         unsigned char curcolor;
        	Uint32 num = 0;
-	int r,g,b,color;
-	SDL_Rect rect;
 
+	E_Screen->mark_dirty(startx, starty, xsize, ysize);
 	for(cury = starty;cury < starty +ysize;cury++)
  	{	
 		for (curx = startx; curx < startx +xsize; curx++)
@@ -790,16 +669,7 @@ void video::putdatatext(Sint32 startx, Sint32 starty, Sint32 xsize, Sint32 ysize
 			curcolor = sourcedata[num++];
 			if (!curcolor)
 		        	continue;
-	        	//point(curx,cury,curcolor);//buffers: PORT: draw the poin
-			query_palette_reg(curcolor,&r,&g,&b);
-			color = SDL_MapRGB(E_Screen->render->format,r*4,g*4,b*4);
-
-			rect.x = curx;
-			rect.y = cury;
-			rect.w = 1;
-			rect.h = 1;
-			Log("test\n");
-			SDL_FillRect(E_Screen->render,&rect,color);
+	        	pointb(curx,cury,curcolor);
 		}
     	}
 }
@@ -813,6 +683,7 @@ void video::putdata(Sint32 startx, Sint32 starty, Sint32 xsize, Sint32 ysize, un
 	unsigned char curcolor;
 	Uint32 num = 0;
 
+	E_Screen->mark_dirty(startx, starty, xsize, ysize);
 	for(cury = starty;cury < starty +ysize;cury++)
 		for (curx = startx; curx < startx +xsize; curx++)
 		{
@@ -834,9 +705,8 @@ void video::putdatatext(Sint32 startx, Sint32 starty, Sint32 xsize, Sint32 ysize
         Sint32 curx, cury;
         unsigned char curcolor;
         Uint32 num = 0;
-	int r,g,b,scolor;
-	SDL_Rect rect;
 
+       E_Screen->mark_dirty(startx, starty, xsize, ysize);
        for(cury = starty;cury < starty +ysize;cury++)
 	       for (curx = startx; curx < startx +xsize; curx++)
                {
@@ -846,14 +716,7 @@ void video::putdatatext(Sint32 startx, Sint32 starty, Sint32 xsize, Sint32 ysize
 				//if (curcolor>=248) curcolor = color+(curcolor-248);
 			if (curcolor>247)
 			        curcolor = color;
-			query_palette_reg(curcolor,&r,&g,&b);
-			scolor = SDL_MapRGB(E_Screen->render->format,r*4,g*4,b*4);
-
-            rect.x = curx;
-            rect.y = cury;
-			rect.w = 1;	
-			rect.h = 1;
-			SDL_FillRect(E_Screen->render,&rect,scolor);
+			pointb(curx,cury,curcolor);
 		}
 }
 
@@ -872,11 +735,9 @@ void video::putbuffer(Sint32 tilestartx, Sint32 tilestarty,
                       Sint32 portendx, Sint32 portendy,
                       unsigned char * sourceptr)
 {
-	int i,j,num;
+	int i;
 	Sint32 xmin=0, xmax=tilewidth, ymin=0, ymax=tileheight;
-	//Uint32 targetshifter,sourceshifter; //these let you wrap around in the arrays
 	Sint32 totrows,rowsize; //number of rows and width of each row in the source
-	//Uint32 offssource,offstarget; //offsets into each array, for clipping and wrap
 	unsigned char * sourcebufptr = &sourceptr[0];
 	if (tilestartx >= portendx || tilestarty >= portendy )
 		return; // abort, the tile is drawing outside the clipping region
@@ -884,7 +745,7 @@ void video::putbuffer(Sint32 tilestartx, Sint32 tilestarty,
 	if ((tilestartx + tilewidth) > portendx)   //this clips on the right edge
 		xmax = portendx - tilestartx; //stop drawing after xmax bytes
 
-	else if (tilestartx < portstartx) //this clips on the left edge
+	if (tilestartx < portstartx) //this clips on the left edge
 	{
 		xmin = portstartx - tilestartx;
 		tilestartx = portstartx;
@@ -893,7 +754,7 @@ void video::putbuffer(Sint32 tilestartx, Sint32 tilestarty,
 	if ((tilestarty + tileheight) > portendy) //this clips on the bottom edge
 		ymax = portendy - tilestarty;
 
-	else if (tilestarty < portstarty) //this clips the top edge
+	if (tilestarty < portstarty) //this clips the top edge
 	{
 		ymin = portstarty - tilestarty;
 		tilestarty = portstarty;
@@ -904,22 +765,12 @@ void video::putbuffer(Sint32 tilestartx, Sint32 tilestarty,
 	if (totrows <= 0 || rowsize <= 0)
 		return; //this happens on bad args
 
-	//targetshifter = VIDEO_BUFFER_WIDTH - rowsize; //this will wrap the target around
-	//sourceshifter = tilewidth - rowsize;  //this will wrap the source around
-
-	//offstarget = (tilestarty*VIDEO_BUFFER_WIDTH) + tilestartx; //start at u-l position
-	//offssource = (ymin * tilewidth) + xmin; //start at u-l position
+	E_Screen->mark_dirty(tilestartx, tilestarty, rowsize, totrows);
 
-	//buffers: draws graphic. actually uses the above bound checking now (7/18/02)
-	num=0;
+	// tiles are opaque, so each clipped row is a straight copy
 	for(i=ymin;i<ymax;i++)
-	{
-		for(j=xmin;j<xmax;j++)
-		{
-			num = i*tilewidth + j;
-			pointb(j+tilestartx-xmin,i+tilestarty-ymin,sourcebufptr[num]);
-		}
-	}
+		memcpy(&videobuffer[(i+tilestarty-ymin)*VIDEO_BUFFER_WIDTH + tilestartx],
+		       &sourcebufptr[i*tilewidth + xmin], rowsize);
 }
 
 void video::putbuffer_alpha(Sint32 tilestartx, Sint32 tilestarty,
@@ -928,19 +779,18 @@ void video::putbuffer_alpha(Sint32 tilestartx, Sint32 tilestarty,
                       Sint32 portendx, Sint32 portendy,
                       unsigned char * sourceptr, unsigned char alpha)
 {
-	int i,j,num;
+	int i;
 	Sint32 xmin=0, xmax=tilewidth, ymin=0, ymax=tileheight;
-	//Uint32 targetshifter,sourceshifter; //these let you wrap around in the arrays
 	Sint32 totrows,rowsize; //number of rows and width of each row in the source
-	//Uint32 offssource,offstarget; //offsets into each array, for clipping and wrap
 	unsigned char * sourcebufptr = &sourceptr[0];
+	const unsigned char * table;
 	if (tilestartx >= portendx || tilestarty >= portendy )
 		return; // abort, the tile is drawing outside the clipping region
 
 	if ((tilestartx + tilewidth) > portendx)   //this clips on the right edge
 		xmax = portendx - tilestartx; //stop drawing after xmax bytes
 
-	else if (tilestartx < portstartx) //this clips on the left edge
+	if (tilestartx < portstartx) //this clips on the left edge
 	{
 		xmin = portstartx - tilestartx;
 		tilestartx = portstartx;
@@ -949,7 +799,7 @@ void video::putbuffer_alpha(Sint32 tilestartx, Sint32 tilestarty,
 	if ((tilestarty + tileheight) > portendy) //this clips on the bottom edge
 		ymax = portendy - tilestarty;
 
-	else if (tilestarty < portstarty) //this clips the top edge
+	if (tilestarty < portstarty) //this clips the top edge
 	{
 		ymin = portstarty - tilestarty;
 		tilestarty = portstarty;
@@ -960,43 +810,32 @@ void video::putbuffer_alpha(Sint32 tilestartx, Sint32 tilestarty,
 	if (totrows <= 0 || rowsize <= 0)
 		return; //this happens on bad args
 
-	//targetshifter = VIDEO_BUFFER_WIDTH - rowsize; //this will wrap the target around
-	//sourceshifter = tilewidth - rowsize;  //this will wrap the source around
-
-	//offstarget = (tilestarty*VIDEO_BUFFER_WIDTH) + tilestartx; //start at u-l position
-	//offssource = (ymin * tilewidth) + xmin; //start at u-l position
+	E_Screen->mark_dirty(tilestartx, tilestarty, rowsize, totrows);
 
-	//buffers: draws graphic. actually uses the above bound checking now (7/18/02)
-	num=0;
+	table = query_blend_table(alpha);
 	for(i=ymin;i<ymax;i++)
-	{
-		for(j=xmin;j<xmax;j++)
-		{
-			num = i*tilewidth + j;
-			pointb(j+tilestartx-xmin,i+tilestarty-ymin,sourcebufptr[num], alpha);
-		}
-	}
+		blend_row(&videobuffer[(i+tilestarty-ymin)*VIDEO_BUFFER_WIDTH + tilestartx],
+		          &sourcebufptr[i*tilewidth + xmin], rowsize, table);
 }
 
 //buffers: this is the SDL_Surface accelerated version of putbuffer
+// The surface holds the same 8-bit palette indices as the framebuffer.
 void video::putbuffer(Sint32 tilestartx, Sint32 tilestarty,
                       Sint32 tilewidth, Sint32 tileheight,
                       Sint32 portstartx, Sint32 portstarty,
                       Sint32 portendx, Sint32 portendy,
                       SDL_Surface *sourceptr)
 {
-	SDL_Rect rect,temp;
+	int i;
 	Sint32 xmin=0, xmax=tilewidth, ymin=0, ymax=tileheight;
-	//Uint32 targetshifter,sourceshifter; //these let you wrap around in the arrays
 	Sint32 totrows,rowsize; //number of rows and width of each row in the source
-	//Uint32 offssource,offstarget; //offsets into each array, for clipping and wrap
-	//buffers: unsigned char * sourcebufptr = &sourceptr[0];
+	Uint8 *sourcebufptr = (Uint8 *)sourceptr->pixels;
 	if (tilestartx >= portendx || tilestarty >= portendy )
 		return; // abort, the tile is drawing outside the clipping region
 
 	if ((tilestartx + tilewidth) > portendx)   //this clips on the right edge
 		xmax = portendx - tilestartx; //stop drawing after xmax bytes
-	else if (tilestartx < portstartx) //this clips on the left edge
+	if (tilestartx < portstartx) //this clips on the left edge
 	{
 		xmin = portstartx - tilestartx;
 		tilestartx = portstartx;
@@ -1004,7 +843,7 @@ void video::putbuffer(Sint32 tilestartx, Sint32 tilestarty,
 
 	if ((tilestarty + tileheight) > portendy) //this clips on the bottom edge
 		ymax = portendy - tilestarty;
-	else if (tilestarty < portstarty) //this clips the top edge
+	if (tilestarty < portstarty) //this clips the top edge
 	{
 		ymin = portstarty - tilestarty;
 		tilestarty = portstarty;
@@ -1015,19 +854,11 @@ void video::putbuffer(Sint32 tilestartx, Sint32 tilestarty,
 	if (totrows <= 0 || rowsize <= 0)
 		return; //this happens on bad args
 
-	//targetshifter = VIDEO_BUFFER_WIDTH - rowsize; //this will wrap the target around
-	//sourceshifter = tilewidth - rowsize;  //this will wrap the source around
+	E_Screen->mark_dirty(tilestartx, tilestarty, rowsize, totrows);
 
-	//offstarget = (tilestarty*VIDEO_BUFFER_WIDTH) + tilestartx; //start at u-l position
-	//offssource = (ymin * tilewidth) + xmin; //start at u-l position
-
-	rect.x = (tilestartx);
-	rect.y = (tilestarty);
-	temp.x = xmin;
-	temp.y = ymin;
-	temp.w = (xmax-xmin);
-	temp.h = (ymax-ymin);
-	SDL_BlitSurface(sourceptr,&temp,E_Screen->render,&rect);
+	for(i=ymin;i<ymax;i++)
+		memcpy(&videobuffer[(i+tilestarty-ymin)*VIDEO_BUFFER_WIDTH + tilestartx],
+		       &sourcebufptr[i*sourceptr->pitch + xmin], rowsize);
 }
 
 
@@ -1053,14 +884,17 @@ void video::walkputbuffer(Sint32 walkerstartx, Sint32 walkerstarty,
 	if (walkerstartx >= portendx || walkerstarty >= portendy)
 		return; //walker is below or to the right of the viewport
 
+	if (walkerstartx + walkerwidth > portendx) //clip the right edge
+		xmax = portendx - walkerstartx; //stop drawing walker at xmax
+
 	if (walkerstartx < portstartx) //clip the left edge of the view
 	{
 		xmin = portstartx-walkerstartx;  //start drawing walker at xmin
 		walkerstartx = portstartx;
 	}
 
-	else if (walkerstartx + walkerwidth > portendx) //clip the right edge
-		xmax = portendx - walkerstartx; //stop drawing walker at xmax
+	if (walkerstarty + walkerheight > portendy) //clip the bottom edge
+		ymax = portendy - walkerstarty; //stop drawing walker at ymax
 
 	if (walkerstarty < portstarty) // clip the top edge
 	{
@@ -1068,16 +902,12 @@ void video::walkputbuffer(Sint32 walkerstartx, Sint32 walkerstarty,
 		walkerstarty = portstarty;
 	}
 
-	else if (walkerstarty + walkerheight > portendy) //clip the bottom edge
-		ymax = portendy - walkerstarty; //stop drawing walker at ymax
-
 	totrows = (ymax-ymin); //how many rows to copy
 	rowsize = (xmax-xmin); //how many bytes to copy
 	if (totrows <= 0 || rowsize <= 0)
 		return; //this happens on bad args
 
-	//note!! the clipper makes the assumption that no object is larger than
-	// the view it will be clipped to in either dimension!!!
+	E_Screen->mark_dirty(walkerstartx, walkerstarty, rowsize, totrows);
 
 	walkshift = walkerwidth - rowsize;
 	buffshift = VIDEO_BUFFER_WIDTH - rowsize;
@@ -1098,14 +928,86 @@ void video::walkputbuffer(Sint32 walkerstartx, Sint32 walkerstarty,
 			}
 			if (curcolor > (unsigned char) 247)
 				curcolor = (unsigned char) (teamcolor+(255-curcolor));
-			//buffers: PORT: videobuffer[buffoff++] = curcolor;
-			pointb(walkerstartx+curx,walkerstarty+cury,curcolor);
+			videobuffer[buffoff++] = curcolor;
 		}
 		walkoff += walkshift;
 		buffoff += buffshift;
 	}
 }
 
+// video::walkputspans
+// same as walkputbuffer, but draws a frame compiled by
+// PixieData::compile_spans, so transparent pixels cost nothing and
+// opaque runs are copied whole
+// spans points at the frame, from PixieData::frame_spans; its team
+// colors are remapped through the PixieData::team_spans cache
+void video::walkputspans(Sint32 walkerstartx, Sint32 walkerstarty,
+                          Sint32 walkerwidth, Sint32 walkerheight,
+                          Sint32 portstartx, Sint32 portstarty,
+                          Sint32 portendx, Sint32 portendy,
+                          unsigned char  *spans, unsigned char teamcolor)
+{
+	Sint32 curx, cury;
+	Sint32 xmin = 0, xmax= walkerwidth , ymin= 0 , ymax= walkerheight;
+	Sint32 start, end, buffoff;
+	unsigned char *row, *source;
+	unsigned char count, run;
+
+	if (walkerstartx >= portendx || walkerstarty >= portendy)
+		return; //walker is below or to the right of the viewport
+
+	if (walkerstartx + walkerwidth > portendx) //clip the right edge
+		xmax = portendx - walkerstartx; //stop drawing walker at xmax
+
+	if (walkerstartx < portstartx) //clip the left edge of the view
+		xmin = portstartx-walkerstartx;  //start drawing walker at xmin
+
+	if (walkerstarty + walkerheight > portendy) //clip the bottom edge
+		ymax = portendy - walkerstarty; //stop drawing walker at ymax
+
+	if (walkerstarty < portstarty) // clip the top edge
+		ymin = portstarty-walkerstarty; //start drawing walker at ymin
+
+	if (ymax <= ymin || xmax <= xmin)
+		return; //this happens on bad args
+
+	E_Screen->mark_dirty(walkerstartx + xmin, walkerstarty + ymin, xmax - xmin, ymax - ymin);
+
+	// every span is plain color from here on
+	spans = PixieData::team_spans(spans, walkerheight, teamcolor);
+
+	for(cury = ymin; cury < ymax; cury++)
+	{
+		row = spans + ((unsigned int*)spans)[cury];
+		buffoff = (walkerstarty + cury)*VIDEO_BUFFER_WIDTH + walkerstartx;
+		curx = 0;
+		for(count = *row++; count > 0; count--)
+		{
+			curx += row[0];
+			run = row[1];
+			source = row + 3;
+			row = source + run;
+
+			start = curx;
+			end = curx + run;
+			curx = end;
+			if (end <= xmin)
+				continue;
+			if (start >= xmax)
+				break;
+			if (start < xmin)
+			{
+				source += xmin - start;
+				start = xmin;
+			}
+			if (end > xmax)
+				end = xmax;
+
+			memcpy(&videobuffer[buffoff + start], source, end - start);
+		}
+	}
+}
+
 void video::walkputbuffer_flash(Sint32 walkerstartx, Sint32 walkerstarty,
                           Sint32 walkerwidth, Sint32 walkerheight,
                           Sint32 portstartx, Sint32 portstarty,
@@ -1117,18 +1019,22 @@ void video::walkputbuffer_flash(Sint32 walkerstartx, Sint32 walkerstarty,
 	Sint32 xmin = 0, xmax= walkerwidth , ymin= 0 , ymax= walkerheight;
 	Sint32 walkoff=0,buffoff=0,walkshift=0,buffshift=0;
 	Sint32 totrows,rowsize;
+	int r,g,b;
 
 	if (walkerstartx >= portendx || walkerstarty >= portendy)
 		return; //walker is below or to the right of the viewport
 
+	if (walkerstartx + walkerwidth > portendx) //clip the right edge
+		xmax = portendx - walkerstartx; //stop drawing walker at xmax
+
 	if (walkerstartx < portstartx) //clip the left edge of the view
 	{
 		xmin = portstartx-walkerstartx;  //start drawing walker at xmin
 		walkerstartx = portstartx;
 	}
 
-	else if (walkerstartx + walkerwidth > portendx) //clip the right edge
-		xmax = portendx - walkerstartx; //stop drawing walker at xmax
+	if (walkerstarty + walkerheight > portendy) //clip the bottom edge
+		ymax = portendy - walkerstarty; //stop drawing walker at ymax
 
 	if (walkerstarty < portstarty) // clip the top edge
 	{
@@ -1136,16 +1042,12 @@ void video::walkputbuffer_flash(Sint32 walkerstartx, Sint32 walkerstarty,
 		walkerstarty = portstarty;
 	}
 
-	else if (walkerstarty + walkerheight > portendy) //clip the bottom edge
-		ymax = portendy - walkerstarty; //stop drawing walker at ymax
-
 	totrows = (ymax-ymin); //how many rows to copy
 	rowsize = (xmax-xmin); //how many bytes to copy
 	if (totrows <= 0 || rowsize <= 0)
 		return; //this happens on bad args
 
-	//note!! the clipper makes the assumption that no object is larger than
-	// the view it will be clipped to in either dimension!!!
+	E_Screen->mark_dirty(walkerstartx, walkerstarty, rowsize, totrows);
 
 	walkshift = walkerwidth - rowsize;
 	buffshift = VIDEO_BUFFER_WIDTH - rowsize;
@@ -1168,30 +1070,9 @@ void video::walkputbuffer_flash(Sint32 walkerstartx, Sint32 walkerstarty,
 			if (curcolor > (unsigned char) 247)
 				curcolor = (unsigned char) (teamcolor+(255-curcolor));
 			
-			int r,g,b;
+			// Brighten by 100 (of 255), then find the closest palette color
             query_palette_reg(curcolor,&r,&g,&b);
-            r *= 4;
-            g *= 4;
-            b *= 4;
-            
-            if(r > 155)
-                r = 255;
-            else
-                r += 100;
-            
-            if(g > 155)
-                g = 255;
-            else
-                g += 100;
-            
-            if(b > 155)
-                b = 255;
-            else
-                b += 100;
-            
-            
-			//buffers: PORT: videobuffer[buffoff++] = curcolor;
-			pointb(walkerstartx+curx,walkerstarty+cury,r, g, b);
+            videobuffer[buffoff++] = nearest_palette_index(r + 25, g + 25, b + 25);
 		}
 		walkoff += walkshift;
 		buffoff += buffshift;
@@ -1209,19 +1090,21 @@ void video::walkputbuffertext(Sint32 walkerstartx, Sint32 walkerstarty,
         Sint32 xmin = 0, xmax= walkerwidth , ymin= 0 , ymax= walkerheight;
         Sint32 walkoff=0,buffoff=0,walkshift=0,buffshift=0;
         Sint32 totrows,rowsize;
-	int r,g,b,color;
-	SDL_Rect rect;
 
         if (walkerstartx >= portendx || walkerstarty >= portendy)
                 return; //walker is below or to the right of the viewport
 
+        if (walkerstartx + walkerwidth > portendx) //clip the right edge
+                xmax = portendx - walkerstartx; //stop drawing walker at xmax
+
         if (walkerstartx < portstartx) //clip the left edge of the view
         {
                 xmin = portstartx-walkerstartx;  //start drawing walker at xmin
                 walkerstartx = portstartx;
         }
-	else if (walkerstartx + walkerwidth > portendx) //clip the right edge
-                xmax = portendx - walkerstartx; //stop drawing walker at xmax
+
+        if (walkerstarty + walkerheight > portendy) //clip the bottom edge
+                ymax = portendy - walkerstarty; //stop drawing walker at ymax
 
         if (walkerstarty < portstarty) // clip the top edge
         {
@@ -1229,16 +1112,12 @@ void video::walkputbuffertext(Sint32 walkerstartx, Sint32 walkerstarty,
                 walkerstarty = portstarty;
         }
 
-        else if (walkerstarty + walkerheight > portendy) //clip the bottom edge
-                ymax = portendy - walkerstarty; //stop drawing walker at ymax
-
         totrows = (ymax-ymin); //how many rows to copy
         rowsize = (xmax-xmin); //how many bytes to copy
         if (totrows <= 0 || rowsize <= 0)
                 return; //this happens on bad args
 
-        //note!! the clipper makes the assumption that no object is larger than
-        // the view it will be clipped to in either dimension!!!
+        E_Screen->mark_dirty(walkerstartx, walkerstarty, rowsize, totrows);
 
         walkshift = walkerwidth - rowsize;
         buffshift = VIDEO_BUFFER_WIDTH - rowsize;
@@ -1258,14 +1137,7 @@ void video::walkputbuffertext(Sint32 walkerstartx, Sint32 walkerstarty,
                         }
                         if (curcolor > (unsigned char) 247)
                                 curcolor = (unsigned char) (teamcolor+(255-curcolor));
-			query_palette_reg(curcolor,&r,&g,&b);
-                        color = SDL_MapRGB(E_Screen->render->format,r*4,g*4,b*4);
-
-                        rect.x = (curx + walkerstartx);
-                        rect.y = (cury + walkerstarty);
-                        rect.w = 1;
-                        rect.h = 1;
-                        SDL_FillRect(E_Screen->render,&rect,color);
+                        videobuffer[buffoff++] = curcolor;
                 }
                 walkoff += walkshift;
                 buffoff += buffshift;
@@ -1283,17 +1155,22 @@ void video::walkputbuffertext_alpha(Sint32 walkerstartx, Sint32 walkerstarty,
         Sint32 xmin = 0, xmax= walkerwidth , ymin= 0 , ymax= walkerheight;
         Sint32 walkoff=0,buffoff=0,walkshift=0,buffshift=0;
         Sint32 totrows,rowsize;
+        const unsigned char *fill;
 
         if (walkerstartx >= portendx || walkerstarty >= portendy)
                 return; //walker is below or to the right of the viewport
 
+        if (walkerstartx + walkerwidth > portendx) //clip the right edge
+                xmax = portendx - walkerstartx; //stop drawing walker at xmax
+
         if (walkerstartx < portstartx) //clip the left edge of the view
         {
                 xmin = portstartx-walkerstartx;  //start drawing walker at xmin
                 walkerstartx = portstartx;
         }
-	else if (walkerstartx + walkerwidth > portendx) //clip the right edge
-                xmax = portendx - walkerstartx; //stop drawing walker at xmax
+
+        if (walkerstarty + walkerheight > portendy) //clip the bottom edge
+                ymax = portendy - walkerstarty; //stop drawing walker at ymax
 
         if (walkerstarty < portstarty) // clip the top edge
         {
@@ -1301,17 +1178,14 @@ void video::walkputbuffertext_alpha(Sint32 walkerstartx, Sint32 walkerstarty,
                 walkerstarty = portstarty;
         }
 
-        else if (walkerstarty + walkerheight > portendy) //clip the bottom edge
-                ymax = portendy - walkerstarty; //stop drawing walker at ymax
-
         totrows = (ymax-ymin); //how many rows to copy
         rowsize = (xmax-xmin); //how many bytes to copy
         if (totrows <= 0 || rowsize <= 0)
                 return; //this happens on bad args
 
-        //note!! the clipper makes the assumption that no object is larger than
-        // the view it will be clipped to in either dimension!!!
+        E_Screen->mark_dirty(walkerstartx, walkerstarty, rowsize, totrows);
 
+        fill = query_blend_table(alpha) + teamcolor*256;
         walkshift = walkerwidth - rowsize;
         buffshift = VIDEO_BUFFER_WIDTH - rowsize;
 
@@ -1328,10 +1202,9 @@ void video::walkputbuffertext_alpha(Sint32 walkerstartx, Sint32 walkerstarty,
                                 buffoff++;
                                 continue;
                         }
-                        if (curcolor > (unsigned char) 247)
-                                curcolor = (unsigned char) (teamcolor+(255-curcolor));
                         
-                        pointb(curx + walkerstartx, cury + walkerstarty, teamcolor, alpha);
+                        videobuffer[buffoff] = fill[videobuffer[buffoff]];
+                        buffoff++;
                 }
                 walkoff += walkshift;
                 buffoff += buffshift;
@@ -1345,7 +1218,8 @@ void video::walkputbuffer(Sint32 walkerstartx, Sint32 walkerstarty,
                           Sint32 portendx, Sint32 portendy,
                           unsigned char  *sourceptr, unsigned char teamcolor,
                           unsigned char mode, Sint32 invisibility,
-                          unsigned char outline, unsigned char shifttype)
+                          unsigned char outline, unsigned char shifttype,
+                          Uint32& seed)
 {
 	Sint32 curx, cury;
 	unsigned char curcolor, bufcolor;
@@ -1354,20 +1228,22 @@ void video::walkputbuffer(Sint32 walkerstartx, Sint32 walkerstarty,
 	Sint32 totrows,rowsize;
 	signed char shift;
 	int yval, xval;
-	Uint8 r,g,b;
-	int tx,ty,tempbuf;
+	int tempbuf;
 
 	if (walkerstartx >= portendx || walkerstarty >= portendy)
 		return; //walker is below or to the right of the viewport
 
+	if (walkerstartx + walkerwidth > portendx) //clip the right edge
+		xmax = portendx - walkerstartx; //stop drawing walker at xmax
+
 	if (walkerstartx < portstartx) //clip the left edge of the view
 	{
 		xmin = portstartx-walkerstartx;  //start drawing walker at xmin
 		walkerstartx = portstartx;
 	}
 
-	else if (walkerstartx + walkerwidth > portendx) //clip the right edge
-		xmax = portendx - walkerstartx; //stop drawing walker at xmax
+	if (walkerstarty + walkerheight > portendy) //clip the bottom edge
+		ymax = portendy - walkerstarty; //stop drawing walker at ymax
 
 	if (walkerstarty < portstarty) // clip the top edge
 	{
@@ -1375,14 +1251,13 @@ void video::walkputbuffer(Sint32 walkerstartx, Sint32 walkerstarty,
 		walkerstarty = portstarty;
 	}
 
-	else if (walkerstarty + walkerheight > portendy) //clip the bottom edge
-		ymax = portendy - walkerstarty; //stop drawing walker at ymax
-
 	totrows = (ymax-ymin); //how many rows to copy
 	rowsize = (xmax-xmin); //how many bytes to copy
 	if (totrows <= 0 || rowsize <= 0)
 		return; //this happens on bad args
 
+	E_Screen->mark_dirty(walkerstartx, walkerstarty, rowsize, totrows);
+
 	//note!! the clipper makes the assumption that no object is larger than
 	// the view it will be clipped to in either dimension!!!
 
@@ -1461,7 +1336,7 @@ void video::walkputbuffer(Sint32 walkerstartx, Sint32 walkerstarty,
 						}
 					} // end outline
 
-					if (random(invisibility) > 8)
+					if (random_from(seed, invisibility) > 8)
 					{
 						xval++;
 						//videobuffer[buffoff++] = teamcolor+random(7);
@@ -1558,7 +1433,7 @@ void video::walkputbuffer(Sint32 walkerstartx, Sint32 walkerstarty,
 					break;
 
 				case SHIFT_RIGHT_RANDOM:
-					shift = (signed char) random(2);
+					shift = (signed char) random_from(seed, 2);
 					break;
 
 				default:
@@ -1580,16 +1455,8 @@ void video::walkputbuffer(Sint32 walkerstartx, Sint32 walkerstarty,
 					//buffers: this is a messy optimization. sorry.
 					if (shifttype == SHIFT_RANDOM)
 					{
-						//pointb(buffoff++,get_pixel(buffoff+random(2)));
-						tempbuf = buffoff+random(2);
-						ty = tempbuf/320;
-						tx = tempbuf-ty*320;
-						get_pixel(tx,ty,&r,&g,&b);
-
-						ty = buffoff/320;
-						tx = buffoff-ty*320;
-						;
-						pointb(tx,ty,(int)r,(int)g,(int)b);
+						tempbuf = buffoff+random_from(seed, 2);
+						pointb(buffoff,get_pixel(tempbuf));
 						buffoff++;
 					}
 
@@ -1676,6 +1543,8 @@ void video::walkputbuffer(Sint32 walkerstartx, Sint32 walkerstarty,
 void video::buffer_to_screen(Sint32 viewstartx,Sint32 viewstarty,
                              Sint32 viewwidth, Sint32 viewheight)
 {
+	if(recording)
+		record_frame();
 	E_Screen->swap(viewstartx,viewstarty,viewwidth,viewheight);
 }
 
@@ -1688,225 +1557,283 @@ void video::swap(void)
 //buffers: get pixel's RGB values if you have XY
 void video::get_pixel(int x, int y, Uint8 *r, Uint8 *g, Uint8 *b)
 {
-	Uint32 col = 0;
-	Uint8 q=0,w=0,e=0;
-
-	char *p = (char *)E_Screen->render->pixels;
-	p += E_Screen->render->pitch*y;
-	p += E_Screen->render->format->BytesPerPixel*x;
-
-	memcpy(&col,p,E_Screen->render->format->BytesPerPixel);
+	int tr,tg,tb;
 
-	SDL_GetRGB(col,E_Screen->render->format,&q,&w,&e);
-	*r=q;
-	*g=w;
-	*b=e;
+	query_palette_reg(videobuffer[y*VIDEO_BUFFER_WIDTH + x],&tr,&tg,&tb);
+	*r=tr*4;
+	*g=tg*4;
+	*b=tb*4;
 }
 
 //buffers: get pixel index if you have XY.
 int video::get_pixel(int x, int y, int *index)
 {
-	Uint8 r,g,b;
-	int tr,tg,tb;
-	int i;
-
-	get_pixel(x,y,&r,&g,&b);
-	r /= 4;
-	g /= 4;
-	b /= 4;
-
-	for(i=0;i<256;i++)
-	{
-		query_palette_reg(i,&tr,&tg,&tb);
-		if(r==tr && g==tg && b==tb)
-		{
-			*index = i;
-			return i;
-		}
-	}
-
-	Log("DEBUG: could not find color: %d %d %d\n",r,g,b);
-	return 0;
+	*index = videobuffer[y*VIDEO_BUFFER_WIDTH + x];
+	return *index;
 }
 
 //buffers: get pixel index if you have an buffer offset
 int video::get_pixel(int offset)
 {
-	int x,y,t;
-
-	y = offset/320;
-	x = offset-y*320;
+	if (offset < 0 || offset >= VIDEO_SIZE)
+		return 0;
 
-	return get_pixel(x,y,&t);
+	return videobuffer[offset];
 }
 
 #ifndef USE_BMP_SCREENSHOT
 #include "../util/savepng.h"
 #endif
 
-bool video::save_screenshot()
+// Screenshots and recorded frames are written by a thread of their own.
+// The main thread only copies the indexed frame and its palette into one
+// of a few slots; when they are all waiting to be written the frame is
+// dropped rather than holding the game up.
+#define CAPTURE_SLOTS 8
+
+struct CaptureFrame
 {
-    SDL_Surface* surf;
-    
-	switch(E_Screen->Engine)
+	unsigned char pixels[VIDEO_SIZE];
+	unsigned char palette[768];
+	char filename[40];
+};
+
+static CaptureFrame* capture_frames = NULL;
+static int capture_head = 0;  // next slot to fill, main thread only
+static int capture_tail = 0;  // next slot to write, capture thread only
+static SDL_sem* capture_free = NULL;
+static SDL_sem* capture_queued = NULL;
+static SDL_Thread* capture_thread = NULL;
+static SDL_atomic_t capture_quit;  // set to 1 to stop the capture thread
+
+static bool write_capture(CaptureFrame* frame)
+{
+	SDL_Surface* surf = SDL_CreateRGBSurfaceFrom(frame->pixels, CX_SCREEN, CY_SCREEN, 8, VIDEO_BUFFER_WIDTH, 0, 0, 0, 0);
+	if(surf == NULL)
+		return false;
+	
+	SDL_Color colors[256];
+	for(int i = 0; i < 256; i++)
+	{
+		colors[i].r = frame->palette[i*3] * 4;
+		colors[i].g = frame->palette[i*3+1] * 4;
+		colors[i].b = frame->palette[i*3+2] * 4;
+		colors[i].a = 255;
+	}
+	SDL_SetPaletteColors(surf->format->palette, colors, 0, 256);
+	
+	bool result = false;
+	SDL_RWops* rwops = open_write_file(frame->filename);
+	if(rwops == NULL)
+		Log("Failed to open file for screenshot.\n");
+	else
+	{
+		#ifndef USE_BMP_SCREENSHOT
+		result = (SDL_SavePNG_RW(surf, rwops, 1) >= 0);
+		#else
+		result = (SDL_SaveBMP_RW(surf, rwops, 1) >= 0);
+		#endif
+	}
+	
+	SDL_FreeSurface(surf);
+	return result;
+}
+
+static int capture_worker(void* data)
+{
+	while(1)
+	{
+		SDL_SemWait(capture_queued);
+		if(SDL_AtomicGet(&capture_quit))
+			break;
+		
+		if(!write_capture(&capture_frames[capture_tail]))
+			Log("Failed to save %s\n", capture_frames[capture_tail].filename);
+		capture_tail = (capture_tail + 1) % CAPTURE_SLOTS;
+		SDL_SemPost(capture_free);
+	}
+	return 0;
+}
+
+static bool start_capture_thread()
+{
+	if(capture_thread != NULL)
+		return true;
+	
+	capture_frames = new CaptureFrame[CAPTURE_SLOTS];
+	capture_head = capture_tail = 0;
+	SDL_AtomicSet(&capture_quit, 0);
+	capture_free = SDL_CreateSemaphore(CAPTURE_SLOTS);
+	capture_queued = SDL_CreateSemaphore(0);
+	capture_thread = SDL_CreateThread(capture_worker, "capture", NULL);
+	if(capture_thread == NULL)
 	{
-		case SAI:
-		case EAGLE:
-            surf = E_Screen->render2;
-		    break;
-        default:
-            surf = E_Screen->render;
-            break;
+		Log("Could not start capture thread: %s\n", SDL_GetError());
+		SDL_DestroySemaphore(capture_free);
+		SDL_DestroySemaphore(capture_queued);
+		delete[] capture_frames;
+		capture_frames = NULL;
+		return false;
 	}
+	return true;
+}
+
+// Lets the frames already queued be written first
+static void stop_capture_thread()
+{
+	if(capture_thread == NULL)
+		return;
+	
+	for(int i = 0; i < CAPTURE_SLOTS; i++)
+		SDL_SemWait(capture_free);
+	SDL_AtomicSet(&capture_quit, 1);
+	SDL_SemPost(capture_queued);
+	SDL_WaitThread(capture_thread, NULL);
+	capture_thread = NULL;
 	
+	SDL_DestroySemaphore(capture_free);
+	SDL_DestroySemaphore(capture_queued);
+	delete[] capture_frames;
+	capture_frames = NULL;
+}
+
+// Queues the current frame to be written to 'filename'
+bool video::capture_frame(const char* filename)
+{
+	if(!start_capture_thread())
+		return false;
+	if(SDL_SemTryWait(capture_free) != 0)
+		return false;
+	
+	CaptureFrame* frame = &capture_frames[capture_head];
+	memcpy(frame->pixels, videobuffer, VIDEO_SIZE);
+	query_palette(frame->palette);
+	snprintf(frame->filename, sizeof(frame->filename), "%s", filename);
+	capture_head = (capture_head + 1) % CAPTURE_SLOTS;
+	SDL_SemPost(capture_queued);
+	return true;
+}
+
+bool video::save_screenshot()
+{
 	static int i = 1;
-	char buf[200];
+	char buf[40];
     #ifndef USE_BMP_SCREENSHOT
-	snprintf(buf, 200, "screenshot%d.png", i);
+	snprintf(buf, 40, "screenshot%d.png", i);
 	#else
-	snprintf(buf, 200, "screenshot%d.bmp", i);
+	snprintf(buf, 40, "screenshot%d.bmp", i);
 	#endif
+	
+	if(!capture_frame(buf))
+	{
+		Log("Too busy to save a screenshot.\n");
+		return false;
+	}
+	
 	i++;
+	Log("Saving screenshot: %s\n", buf);
+	return true;
+}
+
+// Starts or stops writing every record_every'th shown frame to a
+// numbered sequence
+void video::toggle_recording()
+{
+	static int take = 0;
 	
-	SDL_RWops* rwops = open_write_file(buf);
-	if(rwops == NULL)
-    {
-        Log("Failed to open file for screenshot.\n");
-        return false;
-    }
-    
-    Log("Saving screenshot: %s\n", buf);
-    
+	if(recording)
+	{
+		recording = false;
+		Log("Stopped recording after %d frames.\n", record_frames);
+		return;
+	}
+	
+	take++;
+	record_frames = 0;
+	record_count = 0;
+	record_take = take;
+	record_every = toInt(cfg.get_setting("graphics", "record_every"));
+	if(record_every < 1)
+		record_every = 1;
+	recording = true;
+	Log("Recording every %d frames to record%d_*\n", record_every, take);
+}
+
+void video::record_frame()
+{
+	if(record_count++ % record_every != 0)
+		return;
+	
+	char buf[40];
     #ifndef USE_BMP_SCREENSHOT
-    // Make it safe to save (convert alpha channel)
-    surf = SDL_PNGFormatAlpha(surf);
-    
-    // Save it
-    bool result = (SDL_SavePNG_RW(surf, rwops, 1) >= 0);
-    SDL_FreeSurface(surf);
-    #else
-    bool result = (SDL_SaveBMP_RW(surf, rwops, 1) >= 0);
-    
-    #endif
-    
-    return result;
+	snprintf(buf, 40, "record%d_%05d.png", record_take, record_frames);
+	#else
+	snprintf(buf, 40, "record%d_%05d.bmp", record_take, record_frames);
+	#endif
+	if(capture_frame(buf))
+		record_frames++;
 }
 
 
 // ***************************************************************************
-// Fading routines! Thanks, Erik!
+// Fading routines.  The frame is indexed, so a fade only has to change
+// the 256 palette entries each step, or mix two frames through a table.
 // ****************************************************************************
-void video::FadeBetween24(
-//Show transition between two screens at 'amount' between them.
-//
-//'pSurface' is the surface you want to apply the fade to,
-//'fadeFrom' is a copy of what the old screen looks like, and
-//'fadeTo' is a copy of what the normal screen looks like,
-// neither faded in or out, but just normal.
-//NOTE: fadeFrom, fadeTo, and pSurface must be the same size and dimensions.
-//
-//Params:
-	SDL_Surface* pSurface, const Uint8* fadeFromRGB, const Uint8* fadeToRGB,
-	const int amount)	//(in) mixing ratio (in increments of 'fadeDuration')
+
+// Steps the palette from 'frompal' to 'topal' over fadeDuration.  Ends
+// with 'topal' set; returns -1 if a key cut it short.
+int video::fade_palette(const unsigned char* frompal, const unsigned char* topal)
 {
-	Uint8 *pw = (Uint8 *)pSurface->pixels;
-	Uint32 size = pSurface->pitch * pSurface->h;
+	int i = 1;
 
-	const int nOldAmt = fadeDuration-amount;
+	//Fade from old to new palette.  Effect takes constant time.
+	Uint32
+		dwFirstPaint = SDL_GetTicks(),
+		dwNow = dwFirstPaint;
+	do {
+		set_mixed_palette(frompal, topal,
+				dwNow - dwFirstPaint + 50, fadeDuration);	//allow first frame to show some change
+		swap();
+		dwNow = SDL_GetTicks();
 
-	const Uint8 *pFrom = fadeFromRGB;
-	const Uint8 *pTo = fadeToRGB;
-	
-	//Mix pixels in "from" and "to" images by 'amount'
-	Uint8 *pStop = pw + size;
-	while (pw != pStop)
-	{
-		*(pw++) = (nOldAmt * *(pFrom++) + amount * *(pTo++)) / fadeDuration;
-		*(pw++) = (nOldAmt * *(pFrom++) + amount * *(pTo++)) / fadeDuration;
-		*(pw++) = (nOldAmt * *(pFrom++) + amount * *(pTo++)) / fadeDuration;
-		pw++; pFrom++; pTo++;
-	}
-    
-	// FIXME!  Need to pass in the Screen structure.
-	//SDL_UpdateRect (pSurface, 0, 0, 0, 0);
+		get_input_events(POLL);
+		if (query_key_press_event())
+		{
+			i = -1;
+			break;
+		}
+	} while (Sint32(dwNow) - Sint32(dwFirstPaint) + 50 < fadeDuration);	// constant-time effect
+
+	set_mixed_palette(frompal, topal, fadeDuration, fadeDuration);
+	swap();
+
+	return i;
 }
 
-//*****************************************************************************
-int video::FadeBetween(
-//Fade between two screens.
-//Time effect to be independent of machine speed.
-	SDL_Surface* pOldSurface,	//(in)	Surface that contains starting image.
-	SDL_Surface* pNewSurface,	//(in)	Image that destination surface will change to.
-	SDL_Surface* DestSurface)	//	surface which is the destination
+// Mixes from 'old_frame' to what is in the buffer now over fadeDuration,
+// through the blend tables.  Both frames are in the normal palette.
+int video::crossfade(const unsigned char* old_frame)
 {
-	bool bOldNull = false, bNewNull = false;
+	const int size = CX_SCREEN*CY_SCREEN;
+	unsigned char* new_frame = new unsigned char[size];
 	int i = 1;
 
-	//Set NULL pointers to temporary black screens
-	//(for simple fade-in/out effects).
-	if (!pOldSurface)
-	{
-		bOldNull = true;
-		pOldSurface = SDL_CreateRGBSurface(SDL_SWSURFACE,
-			CX_SCREEN, CY_SCREEN, 24, 0, 0, 0, 0);
-		SDL_FillRect(pOldSurface,NULL,0);
-	}
-	if (!pNewSurface)
-	{
-		bNewNull = true;
-		pNewSurface = SDL_CreateRGBSurface(SDL_SWSURFACE,
-			CX_SCREEN, CY_SCREEN, 24, 0, 0, 0, 0);
-		SDL_FillRect(pNewSurface,NULL,0);
-	}
-	if (bOldNull && bNewNull) return 0;	//nothing to do
+	memcpy(new_frame, videobuffer, size);
 
-	/* Lock the screen for direct access to the pixels */
-	if ( SDL_MUSTLOCK(pOldSurface) ) {
-		if ( SDL_LockSurface(pOldSurface) < 0 ) {
-			return 0;
-		}
-	}
-	
-	//The new surface shouldn't need a lock unless it is somehow a screen surface.
-	ASSERT(!SDL_MUSTLOCK(pNewSurface)); 
-
-	//The dimensions and format of the old and new surface must match exactly.
-	ASSERT(pOldSurface->pitch == pNewSurface->pitch);
-	ASSERT(pOldSurface->w == pNewSurface->w);
-	ASSERT(pOldSurface->h == pNewSurface->h);
-	ASSERT(pOldSurface->format->Rmask == pNewSurface->format->Rmask);
-	ASSERT(pOldSurface->format->Rshift == pNewSurface->format->Rshift);
-	ASSERT(pOldSurface->format->Rloss == pNewSurface->format->Rloss);
-	ASSERT(pOldSurface->format->Gmask == pNewSurface->format->Gmask);
-	ASSERT(pOldSurface->format->Gshift == pNewSurface->format->Gshift);
-	ASSERT(pOldSurface->format->Gloss == pNewSurface->format->Gloss);
-	ASSERT(pOldSurface->format->Bmask == pNewSurface->format->Bmask);
-	ASSERT(pOldSurface->format->Bshift == pNewSurface->format->Bshift);
-	ASSERT(pOldSurface->format->Bloss == pNewSurface->format->Bloss);
-	ASSERT(pOldSurface->format->Rshift == pNewSurface->format->Rshift);
-	ASSERT(pOldSurface->format->BytesPerPixel == pNewSurface->format->BytesPerPixel);
-
-	//Extract RGB pixel values from each image.
-	const int bpp = pNewSurface->format->BytesPerPixel;
-	ASSERT(bpp==4);	//24-bit color only supported
-
-	Uint32 size = pOldSurface->pitch * pOldSurface->h;
-	Uint8 *colorsf, *colorst;
-	colorsf = new Uint8[size];
-	colorst = new Uint8[size];
-
-	Uint8 *prf = (Uint8 *)pOldSurface->pixels, *prt = (Uint8 *)pNewSurface->pixels;
-	memcpy(colorsf, prf, size);
-	memcpy(colorst, prt, size);
-
-	//Fade from old to new surface.  Effect takes constant time.
 	Uint32
 		dwFirstPaint = SDL_GetTicks(),
 		dwNow = dwFirstPaint;
 	do {
-		FadeBetween24(DestSurface,colorsf,colorst,
-				dwNow - dwFirstPaint + 50);	//allow first frame to show some change
-		E_Screen->swap(0,0,320,200);
+		// Steps of 16 keep the tables from being rebuilt every frame
+		int alpha = 256*(dwNow - dwFirstPaint + 50)/fadeDuration;
+		alpha &= ~15;
+		if (alpha > 255)
+			break;
+		const unsigned char* table = query_blend_table(alpha);
+		for (int p = 0; p < size; p++)
+			videobuffer[p] = table[new_frame[p]*256 + old_frame[p]];
+		E_Screen->mark_dirty(0, 0, CX_SCREEN, CY_SCREEN);
+		swap();
 		dwNow = SDL_GetTicks();
 
 		get_input_events(POLL);
@@ -1915,40 +1842,35 @@ int video::FadeBetween(
 			i = -1;
 			break;
 		}
-	} while (Sint32(dwNow) - Sint32(dwFirstPaint) + 50 < fadeDuration);	// constant-time effect
-
-	if ( SDL_MUSTLOCK(pNewSurface) ) {
-		SDL_UnlockSurface(pNewSurface);
-	}
+	} while (Sint32(dwNow) - Sint32(dwFirstPaint) + 50 < fadeDuration);
 
 	//Show new screen entirely.
-	SDL_BlitSurface(pNewSurface, NULL, pOldSurface, NULL);
-	// Screen::Swap() does the work
-	E_Screen->swap(0,0,320,200);
-	
-	//Clean up.
-	delete [] colorsf;
-	delete [] colorst;
-
-	if (bOldNull)
-		SDL_FreeSurface(pOldSurface);
-	if (bNewNull)
-		SDL_FreeSurface(pNewSurface);
+	memcpy(videobuffer, new_frame, size);
+	E_Screen->mark_dirty(0, 0, CX_SCREEN, CY_SCREEN);
+	swap();
 
+	delete[] new_frame;
 	return i;
 }
 
 int video::fadeblack(bool fade_in)
 {
-	SDL_Surface* black = SDL_CreateRGBSurface(SDL_SWSURFACE, 320, 200, 32, 0, 0, 0, 0);
+	unsigned char curpalette[768];
+	unsigned char black[768];
 	int i;
 
+	query_palette(curpalette);
+	memset(black, 0, 768);
+
 	if(fade_in)
-        i = FadeBetween(black, E_Screen->render, E_Screen->render); // fade from black
+        i = fade_palette(black, curpalette); // fade from black
 	else
-        i = FadeBetween(E_Screen->render, black, E_Screen->render); // fade to black
+    {
+        i = fade_palette(curpalette, black); // fade to black
+        clearbuffer();
+        set_palette(curpalette);
+    }
 
-	SDL_FreeSurface(black);
 	return i;
 }
 
@@ -84,6 +84,11 @@ class video
 		                   Sint32 portstartx, Sint32 portstarty,
 		                   Sint32 portendx, Sint32 portendy,
 		                   unsigned char  *sourceptr, unsigned char teamcolor);
+		void walkputspans(Sint32 walkerstartx, Sint32 walkerstarty,
+		                   Sint32 walkerwidth, Sint32 walkerheight,
+		                   Sint32 portstartx, Sint32 portstarty,
+		                   Sint32 portendx, Sint32 portendy,
+		                   unsigned char  *spans, unsigned char teamcolor);
 		void walkputbuffer_flash(Sint32 walkerstartx, Sint32 walkerstarty,
 		                   Sint32 walkerwidth, Sint32 walkerheight,
 		                   Sint32 portstartx, Sint32 portstarty,
@@ -107,7 +112,8 @@ class video
 		                   Sint32 portendx, Sint32 portendy,
 		                   unsigned char  *sourceptr, unsigned char teamcolor,
 		                   unsigned char mode, Sint32 invisibility,
-		                   unsigned char outline, unsigned char shifttype);
+		                   unsigned char outline, unsigned char shifttype,
+		                   Uint32& seed);
 		void buffer_to_screen(Sint32 viewstartx,Sint32 viewstarty,
 		                      Sint32 viewwidth, Sint32 viewheight);
 
@@ -131,21 +137,31 @@ class video
 		int get_pixel(int x, int y, int *index);
 		int get_pixel(int offset);
 		
+		bool capture_frame(const char* filename);
 		bool save_screenshot();
+		void toggle_recording();
+		void record_frame();
 
 		// Fading code: (thanks Erik!)
-		void FadeBetween24(SDL_Surface *, const Uint8 *, const Uint8 *, const int);
-		int FadeBetween(SDL_Surface *, SDL_Surface *, SDL_Surface *);
+		int fade_palette(const unsigned char* frompal, const unsigned char* topal);
+		int crossfade(const unsigned char* old_frame);
 		int fadeblack(bool fade_in);
 
 		int fadeDuration;
 
+		// Recording a numbered sequence of frames
+		bool recording;
+		int record_every; // keep one of this many shown frames
+		int record_count; // frames shown since recording started
+		int record_frames; // frames written so far
+		int record_take; // numbers the sequence files
+
 		unsigned char ourpalette[768]; // our standard glad palette
 		unsigned char redpalette[768]; // for 'faded' backgrounds during menus
 		unsigned char bluepalette[768]; // for special effects like time-freeze
 		unsigned char dospalette[768]; // store the dos palette so we can restore it later
 
-		unsigned char videobuffer[64000]; //our new unified video buffer
+		unsigned char *videobuffer; //our new unified video buffer, E_Screen->framebuffer
 		short cyclemode; //color cycling on or off
 
 
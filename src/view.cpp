@@ -30,6 +30,10 @@
 #include "view_sizes.h"
 #include <algorithm>
 
+// How far past its frame a walker can draw: attack lunges, outlines and
+// its health bar
+#define DRAW_MARGIN 8
+
 //these are for chad's team info page
 #define VIEW_TEAM_TOP    2
 #define VIEW_TEAM_LEFT   20
@@ -166,6 +170,7 @@ viewscreen::viewscreen(short x, short y, short width,
 
 	myradar = new radar(this, myscreen, mynum);
 	radarstart = 0; //the radar has not yet been started
+	draw_seed = 0;
 
 	for (i=0; i < MAX_MESSAGES; i++)
 	{
@@ -186,24 +191,30 @@ viewscreen::~viewscreen()
 
 void viewscreen::clear()
 {
-	unsigned short i;
-
-	for (i=0;i<64000;i++)
-	{
-		myscreen->videobuffer[i] = 0;
-	}
+	myscreen->clearbuffer(xloc, yloc, endx - xloc, endy - yloc);
 }
 
 short viewscreen::redraw()
 {
-	short i,j;
-	short xneg = 0;
-	short yneg = 0;
+	return redraw(&myscreen->level_data);
+}
+
+short viewscreen::redraw(LevelData* data, bool draw_radar)
+{
+	data->prepare_frame(1);
+	prepare_redraw(data, draw_radar);
+	draw_prepared(data, draw_radar);
+	return 1;
+}
+
+// Everything a redraw changes besides this viewscreen's own part of the
+// buffer: where it looks, the level's cached layers and the walkers'
+// drawing state.  screen::redraw() does this for every viewscreen
+// first, so that they can then draw at the same time.  The level's
+// prepare_frame() comes before.
+void viewscreen::prepare_redraw(LevelData* data, bool draw_radar)
+{
 	walker  *controlob = control;
-	pixieN  **backp = myscreen->level_data.back;
-	PixieData& gridp = myscreen->level_data.grid;
-	unsigned short maxx = gridp.w;
-	unsigned short maxy = gridp.h;
 
 	// check if we are partially into a grid square and require
 	//   extra row
@@ -214,102 +225,80 @@ short viewscreen::redraw()
 	}
 	else // no control object now ..
 	{
-		topx = myscreen->level_data.topx;
-		topy = myscreen->level_data.topy;
+		topx = data->topx;
+		topy = data->topy;
 	}
 
+	if (data->background == NULL && data->grid.valid())
+		data->build_background();
 
-	if (topx < 0)
-		xneg = 1;
-	if (topy < 0)
-		yneg = 1;
+	// Drawing may happen on another thread, so it gets its dice now
+	draw_seed = (Uint32) rand();
 
-	//note  >> 4 is equivalent to /16 but faster, since it doesn't divide
-	//likewise <<4 is equivalent to *16, but faster
+	prepare_obs(data);
+	if (shows_radar(draw_radar))
+		myradar->prepare(data);
+}
 
-	for (j=(topy/GRID_SIZE)-yneg;j < ((topy+(yview))/GRID_SIZE) +1; j++)
-		for (i=(topx/GRID_SIZE)-xneg;i < ((topx+(xview))/GRID_SIZE) +1; i++)
-		{
-			// NOTE: back is a PIXIEN.
-			// background graphic [grid(x,y)] -> put in buffer
-			if (i<0 || j<0 || i>=maxx || j>=maxy)
-			{
-				if (j == -1 && i>-1 && i<maxx)  // show side of wall
-					backp[PIX_WALLSIDE1]->draw(i*GRID_SIZE,j*GRID_SIZE, this);
-				else if (j == -2 && i>-1 && i<maxx)  // show top side of wall
-					backp[PIX_H_WALL1]->draw(i*GRID_SIZE,j*GRID_SIZE, this);
-				else                                                                  // show only top of wall
-					backp[PIX_WALLTOP_H]->draw(i*GRID_SIZE,j*GRID_SIZE, this);
-			}
-			else if(gridp.valid())
-				backp[(int)gridp.data[i + maxx * j]]->draw(i*GRID_SIZE,j*GRID_SIZE, this);
-		}
+// Draws into this viewscreen only, after prepare_redraw()
+void viewscreen::draw_prepared(LevelData* data, bool draw_radar)
+{
+	draw_background(data);
 
-	draw_obs(); //moved here to put the radar on top of obs
-	if (control && !control->dead && control->user == mynum && prefs[PREF_RADAR] == PREF_RADAR_ON)
-		myradar->draw();
+	draw_obs(data); //moved here to put the radar on top of obs
+	if (shows_radar(draw_radar))
+		myradar->draw(data);
 	display_text();
-	return 1;
+}
 
+bool viewscreen::shows_radar(bool draw_radar)
+{
+	return (draw_radar && control && !control->dead && control->user == mynum && prefs[PREF_RADAR] == PREF_RADAR_ON);
 }
 
-short viewscreen::redraw(LevelData* data, bool draw_radar)
+// Put the visible part of the level's background into the buffer.
+// The grid itself comes from the level's pre-rendered background in one
+// clipped blit; only the wall border around the map is drawn per tile.
+void viewscreen::draw_background(LevelData* data)
 {
 	short i,j;
 	short xneg = 0;
 	short yneg = 0;
-	walker  *controlob = control;
 	pixieN  **backp = data->back;
 	PixieData& gridp = data->grid;
-	unsigned short maxx = gridp.w;
-	unsigned short maxy = gridp.h;
-
-	// check if we are partially into a grid square and require
-	//   extra row
-	if (controlob)
-	{
-		topx = controlob->xpos - (xview - controlob->sizex)/2;
-		topy = controlob->ypos - (yview - controlob->sizey)/2;
-	}
-	else // no control object now ..
-	{
-		topx = data->topx;
-		topy = data->topy;
-	}
+	short maxx = gridp.w;
+	short maxy = gridp.h;
 
+	if (data->background)
+		myscreen->putbuffer(xloc - topx, yloc - topy,
+		                    data->background_w, data->background_h,
+		                    xloc, yloc, endx, endy,
+		                    data->background);
 
 	if (topx < 0)
 		xneg = 1;
 	if (topy < 0)
 		yneg = 1;
 
-	//note  >> 4 is equivalent to /16 but faster, since it doesn't divide
-	//likewise <<4 is equivalent to *16, but faster
+	// Nothing but the grid is visible, so we're done
+	if (!xneg && !yneg && topx + xview < maxx*GRID_SIZE && topy + yview < maxy*GRID_SIZE)
+		return;
 
 	for (j=(topy/GRID_SIZE)-yneg;j < ((topy+(yview))/GRID_SIZE) +1; j++)
 		for (i=(topx/GRID_SIZE)-xneg;i < ((topx+(xview))/GRID_SIZE) +1; i++)
 		{
 			// NOTE: back is a PIXIEN.
-			// background graphic [grid(x,y)] -> put in buffer
-			if (i<0 || j<0 || i>=maxx || j>=maxy)
-			{
-				if (j == -1 && i>-1 && i<maxx)  // show side of wall
-					backp[PIX_WALLSIDE1]->draw(i*GRID_SIZE,j*GRID_SIZE, this);
-				else if (j == -2 && i>-1 && i<maxx)  // show top side of wall
-					backp[PIX_H_WALL1]->draw(i*GRID_SIZE,j*GRID_SIZE, this);
-				else                                                                  // show only top of wall
-					backp[PIX_WALLTOP_H]->draw(i*GRID_SIZE,j*GRID_SIZE, this);
-			}
-			else if(gridp.valid())
-				backp[(int)gridp.data[i + maxx * j]]->draw(i*GRID_SIZE,j*GRID_SIZE, this);
+			// Cells on the grid were already drawn from the background
+			if (i>=0 && j>=0 && i<maxx && j<maxy)
+				continue;
+
+			if (j == -1 && i>-1 && i<maxx)  // show side of wall
+				backp[PIX_WALLSIDE1]->draw_at(i*GRID_SIZE,j*GRID_SIZE, this);
+			else if (j == -2 && i>-1 && i<maxx)  // show top side of wall
+				backp[PIX_H_WALL1]->draw_at(i*GRID_SIZE,j*GRID_SIZE, this);
+			else                                                                  // show only top of wall
+				backp[PIX_WALLTOP_H]->draw_at(i*GRID_SIZE,j*GRID_SIZE, this);
 		}
-
-	draw_obs(data); //moved here to put the radar on top of obs
-	if (draw_radar && control && !control->dead && control->user == mynum && prefs[PREF_RADAR] == PREF_RADAR_ON)
-		myradar->draw(data);
-	display_text();
-	return 1;
-
 }
 
 void viewscreen::display_text()
@@ -763,7 +752,7 @@ short viewscreen::input(const SDL_Event& event)
 		{
 			newob = myscreen->level_data.add_ob(ORDER_FX, FAMILY_MAGIC_SHIELD);
 			newob->owner = control;
-			newob->team_num = control->team_num;
+			newob->set_team(control->team_num);
 			newob->ani_type = 1; // dummy, non-zero value
 			newob->lifetime = 200;
 			//clear_key_code(SDLK_F2);
@@ -1049,7 +1038,7 @@ short viewscreen::continuous_input()
 	//       draw_box(S_LEFT, S_UP, S_RIGHT-1, S_DOWN-1, 44, 1);  // red flash
 	         // Make temporary stain:
 	         blood = myscreen->level_data.add_ob(ORDER_WEAPON, FAMILY_BLOOD);
-	         blood->team_num = control->team_num;
+	         blood->set_team(control->team_num);
 	         blood->ani_type = ANI_GROW;
 	         blood->setxy(control->xpos,control->ypos);
 	         blood->owner = control;
@@ -1100,33 +1089,47 @@ short viewscreen::draw_obs()
     return draw_obs(&myscreen->level_data);
 }
 
+// The walkers must have had prepare_obs() for this viewscreen
 short viewscreen::draw_obs(LevelData* data)
 {
-	// First draw the special effects
-	for(auto e = data->fxlist.begin(); e != data->fxlist.end(); e++)
-	{
-	    walker* w = *e;
-		if(w && !w->dead)
-			w->draw(this);
-	}
+	for (size_t i = 0; i < visible_obs.size(); i++)
+		visible_obs[i]->draw_prepared(this);
 
-	// Now do real objects
-	for(auto e = data->oblist.begin(); e != data->oblist.end(); e++)
-	{
-	    walker* w = *e;
-		if(w && !w->dead)
-			w->draw(this);
-	}
+	return 1;
+}
+
+// Effects first, then real objects, then weapons, each in list order
+static bool draws_before(walker* a, walker* b)
+{
+	if (a->draw_layer != b->draw_layer)
+		return a->draw_layer < b->draw_layer;
+	return a->draw_order < b->draw_order;
+}
 
-	// Finally draw the weapons
-	for(auto e = data->weaplist.begin(); e != data->weaplist.end(); e++)
+// Finds what can be seen from here through the obmap, rather than
+// drawing every walker of the level and leaving it to the clipper
+void viewscreen::prepare_obs(LevelData* data)
+{
+	data->myobmap->query_rect(topx - DRAW_MARGIN, topy - DRAW_MARGIN,
+	                          xview + 2*DRAW_MARGIN, yview + 2*DRAW_MARGIN,
+	                          visible_obs, true);
+
+	size_t n = 0;
+	for (size_t i = 0; i < visible_obs.size(); i++)
 	{
-	    walker* w = *e;
-		if(w && !w->dead)
-			w->draw(this);
+		walker* w = visible_obs[i];
+		if (w->dead)
+			continue;
+		if (w->xpos + w->sizex + DRAW_MARGIN <= topx || w->xpos - DRAW_MARGIN >= topx + xview
+		        || w->ypos + w->sizey + DRAW_MARGIN <= topy || w->ypos - DRAW_MARGIN >= topy + yview)
+			continue;
+		visible_obs[n++] = w;
 	}
+	visible_obs.resize(n);
+	std::sort(visible_obs.begin(), visible_obs.end(), draws_before);
 
-	return 1;
+	for (size_t i = 0; i < visible_obs.size(); i++)
+		visible_obs[i]->prepare_draw(this);
 }
 
 void viewscreen::resize(short x, short y, short length, short height)
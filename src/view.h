@@ -21,6 +21,7 @@
 
 #include "base.h"
 #include "level_data.h"
+#include <vector>
 
 // Viewscreen-related defines
 #define PREF_LIFE (signed char) 0
@@ -85,6 +86,8 @@ class viewscreen
 		short draw ();
 		short redraw();
 		short redraw(LevelData* data, bool draw_radar = true);
+		void prepare_redraw(LevelData* data, bool draw_radar = true);
+		void draw_prepared(LevelData* data, bool draw_radar = true);
 		short refresh();
 		short input(const SDL_Event& event);
 		short continuous_input();
@@ -94,6 +97,7 @@ class viewscreen
 		void clear_text(void); // clear all text in buffer
 		short draw_obs(); //moved here to fix radar
 		short draw_obs(LevelData* data);
+		void prepare_obs(LevelData* data);
 		void resize(short x, short y, short length, short height);
 		void resize(char whatmode); // set according to preferences ..
 		void view_team();
@@ -121,8 +125,13 @@ class viewscreen
 		signed char prefs[10]; // User preferences ..
 		radar * myradar;
 		short radarstart; //has the radar been started yet?
+		Uint32 draw_seed; // for random_from() while drawing; set by prepare_redraw()
+		std::vector<walker*> visible_obs; // what prepare_obs() found in view, in drawing order
 
 	protected:
+		void draw_background(LevelData* data);
+		bool shows_radar(bool draw_radar);
+		
 		options *prefsob;
 		
 		short size;
@@ -39,9 +39,6 @@ extern Sint32 calculate_level(Uint32 temp_exp);
 extern Sint32 difficulty_level[DIFFICULTY_SETTINGS];
 extern Sint32 current_difficulty;
 
-// from glad.cpp
-short remaining_foes(screen *myscreen, walker* myguy);
-
 walker::walker(const PixieData& data)
     : pixieN(data)
 {
@@ -92,6 +89,11 @@ walker::walker(const PixieData& data)
 	regen_delay = 0;
 	charm_left = 0;
 	outline = 0;
+	memset(view_outline, 0, sizeof(view_outline));
+	memset(view_flash, 0, sizeof(view_flash));
+	frame_flash = false;
+	draw_layer = 1;
+	draw_order = 0;
 	drawcycle = 0;
 
 	skip_exit = 0;
@@ -101,6 +103,12 @@ walker::walker(const PixieData& data)
 	weapons_left = 1; // default, used for fighters
 
 	myobmap = NULL;
+	obmap_x0 = obmap_y0 = obmap_x1 = obmap_y1 = 0;
+	obmap_layer = OBMAP_NONE;
+	mylevel = NULL;
+	counted = 0;
+	counted_team = 0;
+	counted_hired = 0;
 	if(myscreen != NULL)
         myobmap = myscreen->level_data.myobmap;  // default obmap (spatial partitioning optimization?) changed when added to a list
     
@@ -196,6 +204,7 @@ walker::~walker()
 	
 	if(myobmap != NULL)
         myobmap->remove(this); // remove ourselves from obmap lists
+	recount(); // and from the living counts
     
 	delete stats;
 	stats = NULL;
@@ -225,8 +234,8 @@ short walker::setxy(short x, short y)
     
 	if (!ignore)
 		myobmap->move(this, x, y);
-	else // just remove us, in case :)
-		myobmap->remove(this);
+	else // off the collision piles, but still found for drawing
+		myobmap->move_ignored(this, x, y);
 
 	return pixie::setxy(x, y);
 }
@@ -238,8 +247,8 @@ void walker::setworldxy(float x, float y)
     
 	if (!ignore)
 		myobmap->move(this, x, y);
-	else // just remove us, in case :)
-		myobmap->remove(this);
+	else // off the collision piles, but still found for drawing
+		myobmap->move_ignored(this, x, y);
 
 	pixie::setxy(x, y);
 }
@@ -930,6 +939,33 @@ bool float_eq(float a, float b)
     return (a == b || (a - 0.000001f < b && a + 0.000001f > b));
 }
 
+// draw_box(), kept inside the viewscreen so a bar at its edge doesn't
+// spill into the one next to it
+static void draw_box_in_view(Sint32 x1, Sint32 y1, Sint32 x2, Sint32 y2, unsigned char color, Sint32 filled, viewscreen* view_buf)
+{
+    if(!filled)
+    {
+        draw_box_in_view(x1, y1, x2, y1, color, 1, view_buf);
+        draw_box_in_view(x1, y2, x2, y2, color, 1, view_buf);
+        draw_box_in_view(x1, y1, x1, y2, color, 1, view_buf);
+        draw_box_in_view(x2, y1, x2, y2, color, 1, view_buf);
+        return;
+    }
+    
+    if(x1 < view_buf->xloc)
+        x1 = view_buf->xloc;
+    if(y1 < view_buf->yloc)
+        y1 = view_buf->yloc;
+    if(x2 > view_buf->endx - 1)
+        x2 = view_buf->endx - 1;
+    if(y2 > view_buf->endy - 1)
+        y2 = view_buf->endy - 1;
+    if(x1 > x2 || y1 > y2)
+        return;
+    
+    myscreen->draw_box(x1, y1, x2, y2, color, 1);
+}
+
 void draw_smallHealthBar(walker* w, viewscreen* view_buf)
 {
     if(!cfg.is_on("effects", "mini_hp_bar"))
@@ -983,10 +1019,10 @@ void draw_smallHealthBar(walker* w, viewscreen* view_buf)
             Uint16 max_w = r.w;
             
             if(w->last_hitpoints > w->stats->hitpoints && last_ratio <= 1.0f)
-                myscreen->draw_box(r.x, r.y, r.x + r.w*last_ratio, r.y + r.h, 53, 1);
+                draw_box_in_view(r.x, r.y, r.x + r.w*last_ratio, r.y + r.h, 53, 1, view_buf);
                 
-            myscreen->draw_box(r.x, r.y, r.x + r.w*ratio, r.y + r.h, whatcolor, 1);
-            myscreen->draw_box(r.x-1, r.y-1, r.x + max_w+1, r.y + r.h+1, BLACK, 0);
+            draw_box_in_view(r.x, r.y, r.x + r.w*ratio, r.y + r.h, whatcolor, 1, view_buf);
+            draw_box_in_view(r.x-1, r.y-1, r.x + max_w+1, r.y + r.h+1, BLACK, 0, view_buf);
         }
     }
 }
@@ -998,53 +1034,58 @@ walker::DamageNumber::DamageNumber(float x, float y, float value, unsigned char
 
 void walker::DamageNumber::draw(viewscreen* view_buf)
 {
-	Sint32 xscreen = (Sint32) (x - view_buf->topx + view_buf->xloc);
-	Sint32 yscreen = (Sint32) (y - view_buf->topy + view_buf->yloc);
+	Sint32 xview = (Sint32) (x - view_buf->topx);
+	Sint32 yview = (Sint32) (y - view_buf->topy);
 	
 	Uint8 alpha = 0;
 	if(t >= 255)
         alpha = 255;
     else if(t >= 0)
         alpha = t*255;
-    myscreen->text_normal.write_xy_center_alpha(xscreen, yscreen, color, alpha, "%.0f", value);
+    myscreen->text_normal.write_xy_center_alpha(xview, yview, color, alpha, view_buf, "%.0f", value);
 }
 
 #define ATTACK_LUNGE_SIZE 5
 #define HIT_RECOIL_SIZE 3
 
-short walker::draw(viewscreen  *view_buf)
+// Once a frame, for every walker whether it's seen or not, since
+// drawcycle times things like boomerangs: what used to happen on each
+// of the 'views' draws.
+void walker::prepare_frame(short views)
 {
     // Update the drawing coords from the real position
     xpos = worldx;
     ypos = worldy;
     
-	Sint32 xscreen, yscreen;
-
-	//no need for on screen check, it will be checked at the draw level
-	//and the draw level code is cleaner anyway
-	//if (!this) return 0;
 	if (dead)
-	{
-		Log("drawing a dead guy!\n");
-		return 0;
-	}
-	//if (!bmp) {Log("No bitmap!\n"); return 0;}
-	drawcycle++;
-
-	xscreen = (Sint32) (xpos - view_buf->topx + view_buf->xloc);
-	yscreen = (Sint32) (ypos - view_buf->topy + view_buf->yloc);
+		return;
+	drawcycle += views;
 	
-	if(attack_lunge > 0.0f)
-    {
-        xscreen += attack_lunge*ATTACK_LUNGE_SIZE*cos(attack_lunge_angle);
-        yscreen += attack_lunge*ATTACK_LUNGE_SIZE*sin(attack_lunge_angle);
-    }
-    
-	if(hit_recoil > 0.0f)
+	// The first viewscreen to draw us gets the flash
+	frame_flash = hurt_flash;
+	hurt_flash = false;
+	
+	for(auto e = damage_numbers.begin(); e != damage_numbers.end();)
     {
-        xscreen += hit_recoil*HIT_RECOIL_SIZE*cos(hit_recoil_angle);
-        yscreen += hit_recoil*HIT_RECOIL_SIZE*sin(hit_recoil_angle);
+        e->t -= 0.05f*views;
+        if(e->t < 0)
+        {
+            e = damage_numbers.erase(e);
+            continue;
+        }
+        
+        e->y -= 1.5f*views;
+        e++;
     }
+}
+
+// Bookkeeping for drawing on view_buf, the outline cycle and hurt flash.
+// Viewscreens can draw at the same time, so each does this in turn
+// beforehand and draw_prepared() only reads what it left behind.
+void walker::prepare_draw(viewscreen  *view_buf)
+{
+	if (dead)
+		return;
 
 	if (stats->query_bit_flags( BIT_NAMED ) || invisibility_left || flight_left || invulnerable_left)
 	{
@@ -1121,6 +1162,50 @@ short walker::draw(viewscreen  *view_buf)
             outline = OUTLINE_INVISIBLE;
     }
     
+	int view = view_buf->mynum % MAX_VIEWS;
+	view_outline[view] = outline;
+	view_flash[view] = frame_flash;
+	frame_flash = false;
+}
+
+short walker::draw(viewscreen  *view_buf)
+{
+	prepare_frame(1);
+	prepare_draw(view_buf);
+	return draw_prepared(view_buf);
+}
+
+short walker::draw_prepared(viewscreen  *view_buf)
+{
+	Sint32 xscreen, yscreen;
+
+	//no need for on screen check, it will be checked at the draw level
+	//and the draw level code is cleaner anyway
+	//if (!this) return 0;
+	if (dead)
+	{
+		Log("drawing a dead guy!\n");
+		return 0;
+	}
+	//if (!bmp) {Log("No bitmap!\n"); return 0;}
+
+	int view = view_buf->mynum % MAX_VIEWS;
+
+	xscreen = (Sint32) (xpos - view_buf->topx + view_buf->xloc);
+	yscreen = (Sint32) (ypos - view_buf->topy + view_buf->yloc);
+	
+	if(attack_lunge > 0.0f)
+    {
+        xscreen += attack_lunge*ATTACK_LUNGE_SIZE*cos(attack_lunge_angle);
+        yscreen += attack_lunge*ATTACK_LUNGE_SIZE*sin(attack_lunge_angle);
+    }
+    
+	if(hit_recoil > 0.0f)
+    {
+        xscreen += hit_recoil*HIT_RECOIL_SIZE*cos(hit_recoil_angle);
+        yscreen += hit_recoil*HIT_RECOIL_SIZE*sin(hit_recoil_angle);
+    }
+
     bool should_draw_hp = true;
     int fill_mode = 0;
     int outline_style = 0;
@@ -1139,7 +1224,7 @@ short walker::draw(viewscreen  *view_buf)
         {
             fill_mode = INVISIBLE_MODE;
             invisibility_amount = ( invisibility_left + 10 );
-            outline_style = outline;
+            outline_style = view_outline[view];
             should_draw_hp = false;
         }
 	}
@@ -1153,17 +1238,15 @@ short walker::draw(viewscreen  *view_buf)
         outline_style = 1;
         should_draw_hp = false;
     }
-	else if (outline)    // WE HAVE SOME OUTLINE
+	else if (view_outline[view])    // WE HAVE SOME OUTLINE
 	{
 	    fill_mode = OUTLINE_MODE;
-	    outline_style = outline;
+	    outline_style = view_outline[view];
 	}
 	
 	// Draw me
-	if(hurt_flash)
+	if(view_flash[view])
     {
-        hurt_flash = false;
-        
         myscreen->walkputbuffer_flash(xscreen, yscreen, sizex, sizey,
                                    view_buf->xloc, view_buf->yloc,
                                    view_buf->endx, view_buf->endy,
@@ -1173,10 +1256,16 @@ short walker::draw(viewscreen  *view_buf)
     {
         if(fill_mode == 0 && outline_style == 0)
         {
-            myscreen->walkputbuffer(xscreen, yscreen, sizex, sizey,
-                                   view_buf->xloc, view_buf->yloc,
-                                   view_buf->endx, view_buf->endy,
-                                   bmp, query_team_color());
+            if(bmp_spans)
+                myscreen->walkputspans(xscreen, yscreen, sizex, sizey,
+                                       view_buf->xloc, view_buf->yloc,
+                                       view_buf->endx, view_buf->endy,
+                                       bmp_spans, query_team_color());
+            else
+                myscreen->walkputbuffer(xscreen, yscreen, sizex, sizey,
+                                       view_buf->xloc, view_buf->yloc,
+                                       view_buf->endx, view_buf->endy,
+                                       bmp, query_team_color());
         }
         else
         {
@@ -1187,27 +1276,19 @@ short walker::draw(viewscreen  *view_buf)
                                     fill_mode, //mode
                                     invisibility_amount, //invisibility
                                     outline_style, //outline
-                                    phantom_mode); //type of phantom
+                                    phantom_mode, //type of phantom
+                                    view_buf->draw_seed);
         }
     }
 	
 	if(should_draw_hp)
         draw_smallHealthBar(this, view_buf);
 	
-	for(auto e = damage_numbers.begin(); e != damage_numbers.end();)
-    {
-        e->t -= 0.05f;
-        if(e->t < 0)
-        {
-            e = damage_numbers.erase(e);
-            continue;
-        }
-        
-        e->y -= 1.5f;
-        if(view_buf->control == this)
-            e->draw(view_buf);
-        e++;
-    }
+	if(view_buf->control == this)
+	{
+		for(auto e = damage_numbers.begin(); e != damage_numbers.end(); e++)
+			e->draw(view_buf);
+	}
 	
 	if(debug_draw_paths)
         draw_path(view_buf);
@@ -1312,7 +1393,8 @@ short walker::draw_tile(viewscreen  *view_buf)
 		                        PHANTOM_MODE, //mode
 		                        0, //invisibility
 		                        0, //outline
-		                        SHIFT_RANDOM); //type of phantom
+		                        SHIFT_RANDOM, //type of phantom
+		                        view_buf->draw_seed);
 
 	else if (invisibility_left)  //WE ARE INVISIBLE
 	{
@@ -1324,7 +1406,8 @@ short walker::draw_tile(viewscreen  *view_buf)
 			                        INVISIBLE_MODE,  //mode
 			                        ( invisibility_left + 10 ), //invisibility
 			                        outline,  //outline
-			                        0 ); //type of phantom
+			                        0, //type of phantom
+			                        view_buf->draw_seed);
 	}
 	else if (stats->query_bit_flags(BIT_FORESTWALK) && 
 	         myscreen->level_data.mysmoother.query_genre_x_y(xpos/GRID_SIZE, ypos/GRID_SIZE) == TYPE_TREES
@@ -1337,7 +1420,8 @@ short walker::draw_tile(viewscreen  *view_buf)
 		                        INVISIBLE_MODE,  //mode
 		                        1000, //invisibility
 		                        1,  //outline
-		                        0 ); //type of phantom
+		                        0, //type of phantom
+		                        view_buf->draw_seed);
 
 	else if (outline)    // WE HAVE SOME OUTLINE
 	{
@@ -1348,16 +1432,23 @@ short walker::draw_tile(viewscreen  *view_buf)
 		                        OUTLINE_MODE, //mode
 		                        0, //invisibility
 		                        outline, //outline
-		                        0 ); //type of phantom
+		                        0, //type of phantom
+		                        view_buf->draw_seed);
 		                        
         draw_smallHealthBar(this, view_buf);
 	}
 	else
 	{
-		myscreen->walkputbuffer(xscreen, yscreen, sizex, sizey,
-		                       view_buf->xloc, view_buf->yloc,
-		                       xscreen+GRID_SIZE, yscreen+GRID_SIZE,
-		                       bmp, query_team_color());
+		if(bmp_spans)
+			myscreen->walkputspans(xscreen, yscreen, sizex, sizey,
+			                       view_buf->xloc, view_buf->yloc,
+			                       xscreen+GRID_SIZE, yscreen+GRID_SIZE,
+			                       bmp_spans, query_team_color());
+		else
+			myscreen->walkputbuffer(xscreen, yscreen, sizex, sizey,
+			                       view_buf->xloc, view_buf->yloc,
+			                       xscreen+GRID_SIZE, yscreen+GRID_SIZE,
+			                       bmp, query_team_color());
         
         draw_smallHealthBar(this, view_buf);
 	}
@@ -1802,7 +1893,7 @@ void walker::do_hit_effects(walker* attacker, walker* target, short tempdamage)
             if (newob)
             {
                 newob->owner = target;
-                newob->team_num = team_num;
+                newob->set_team(team_num);
                 newob->stats->level = 1;
                 newob->damage = 0;
                 newob->ani_type = 1 + rand()%3;
@@ -2061,7 +2152,8 @@ short walker::attack(walker  *target)
 						sprintf(message, "ENEMY DEATH: %s DIED!", target->stats->name);
 						myscreen->viewob[0]->set_display_text(message, STANDARD_TEXT_TIME);
 					}
-					if(remaining_foes(myscreen, this) == 1)  // This is the last foe
+					// Weapons aren't in oblist, so they have no mylevel to ask
+					if(myscreen->level_data.count_foes(this) == 1)  // This is the last foe
 					{
 						sprintf(message, "All foes defeated!");
 						myscreen->viewob[0]->set_display_text(message, STANDARD_TEXT_TIME);
@@ -2132,7 +2224,7 @@ short walker::attack(walker  *target)
 			/* Blood splats at death */
 			// Make temporary stain:
 			blood = myscreen->level_data.add_ob(ORDER_WEAPON, FAMILY_BLOOD);
-			blood->team_num = target->team_num;
+			blood->set_team(target->team_num);
 			blood->ani_type = ANI_GROW;
 			blood->ignore = 1; // so that we can be walked over .. ?
 			blood->setxy(target->xpos,target->ypos);
@@ -2220,6 +2312,7 @@ short walker::animate()
 			{
 				delete newob->myguy;  // can't be 'sustained' if too low
 				newob->myguy = NULL;
+				newob->recount();
 				strcpy(newob->stats->name, "SLIME"); // generic name
 				newob->stats->level = calculate_level(myguy->exp/2);
 			}
@@ -2238,7 +2331,7 @@ short walker::animate()
 				newob->myguy->exp = exp;
 			}
 
-			newob->team_num = team_num;
+			newob->set_team(team_num);
 			newob->foe = foe;
 			newob->leader = leader;
 			return 1;
@@ -2267,7 +2360,7 @@ walker  *walker::create_weapon()
 	if (query_order() == ORDER_GENERATOR)
 	{
 		weapon = myscreen->level_data.add_ob(ORDER_LIVING, (char) default_weapon);
-		weapon->team_num = team_num;
+		weapon->set_team(team_num);
 		weapon->owner = this;
 		weapon->set_difficulty(stats->level);
 		return weapon;
@@ -2276,7 +2369,7 @@ walker  *walker::create_weapon()
 	weapon_type = current_weapon;
 
 	weapon = myscreen->level_data.add_ob(ORDER_WEAPON, (char) weapon_type);
-	weapon->team_num = team_num;
+	weapon->set_team(team_num);
 	weapon->owner = this;
 	weapon->set_difficulty(stats->level);
 	weapon->damage = (weapon->damage * (stats->level+3))/4;
@@ -2448,7 +2541,7 @@ short walker::special()
 				case 2: // boomerang
 					newob = myscreen->level_data.add_ob(ORDER_FX, FAMILY_BOOMERANG);
 					newob->owner = this;
-					newob->team_num = team_num;
+					newob->set_team(team_num);
 					newob->ani_type = 1; // dummy, non-zero value
 					newob->lifetime = 30 + (stats->level)*12;
 					newob->stats->hitpoints += stats->level*12;
@@ -2475,8 +2568,8 @@ short walker::special()
 					stats->add_command(COMMAND_WALK, 1, -1, -1);
 					
 					{
-                        std::list<walker*> newlist = myscreen->find_foes_in_range(myscreen->level_data.oblist,
-                                                              32+stats->level*2, &howmany, this);
+                        std::vector<walker*> newlist;
+                        howmany = myscreen->find_foes_in_range(this, 32+stats->level*2, newlist);
                         
                         for(auto e = newlist.begin(); e != newlist.end(); e++)
                         {
@@ -2503,8 +2596,8 @@ short walker::special()
 						return 0; // can't do this if no frontal enemy
                     
                     {
-                        std::list<walker*> newlist = myscreen->find_foes_in_range(myscreen->level_data.oblist,
-					                                      28, &howmany, this);
+                        std::vector<walker*> newlist;
+                        howmany = myscreen->find_foes_in_range(this, 28, newlist);
                     
                         generic = 0;
                         
@@ -2542,8 +2635,8 @@ short walker::special()
 				case 1:  // heal / mystic mace
 					if (!shifter_down) // then do normal heal
 					{
-						std::list<walker*> newlist = myscreen->find_friends_in_range(myscreen->level_data.oblist,
-						          60, &howmany, this);
+						std::vector<walker*> newlist;
+						howmany = myscreen->find_friends_in_range(this, 60, newlist);
                         
 						didheal = 0;
 						if (howmany > 1) // some friends here ..
@@ -2627,7 +2720,7 @@ short walker::special()
 						if (!newob) // safety check
 							return 0;
 						newob->owner = this;
-						newob->team_num = team_num;
+						newob->set_team(team_num);
 						newob->ani_type = 1; // dummy, non-zero value
 						// Specify settings based on our mana ..
 						generic = stats->magicpoints - stats->special_cost[(int)current_special];
@@ -2685,7 +2778,7 @@ short walker::special()
 								alive = do_summon(FAMILY_SKELETON, 125 + (stats->level*40) );
 								if (!alive)
 									return 0;
-								alive->team_num = team_num;
+								alive->set_team(team_num);
 								alive->stats->level = random(stats->level) + 1;
 								alive->set_difficulty((Uint32) alive->stats->level);
 								alive->setxy(newob->xpos, newob->ypos);
@@ -2748,7 +2841,7 @@ short walker::special()
 									return 0;
 								alive->stats->level = random(stats->level) + 1;
 								alive->set_difficulty((Uint32) alive->stats->level);
-								alive->team_num = team_num;
+								alive->set_team(team_num);
 								alive->setxy(newob->xpos, newob->ypos);
 								alive->owner = this;
 								//myscreen->remove_fx_ob(newob);
@@ -2782,7 +2875,7 @@ short walker::special()
 								newob->transfer_stats(alive);  // restore our old values ..
 								alive->stats->hitpoints = (alive->stats->max_hitpoints)/2;
 								do_heal_effects(this, alive, (alive->stats->max_hitpoints)/2);
-								alive->team_num = newob->team_num;
+								alive->set_team(newob->team_num);
 								
 								if(myguy) // take some EXP away as penalty if we're a player
 								{
@@ -2798,7 +2891,7 @@ short walker::special()
 								alive = do_summon(FAMILY_GHOST, 200);
 								if (!alive)
 									return 0;
-								alive->team_num = team_num;
+								alive->set_team(team_num);
 								alive->stats->level = random(stats->level) + 1;
 								alive->set_difficulty((Uint32) alive->stats->level);
 								alive->owner = this;
@@ -2942,8 +3035,8 @@ short walker::special()
 						myscreen->viewob[0]->redraw();
 						myscreen->viewob[0]->refresh();
 						//myscreen->buffer_to_screen(0, 0, 320, 200);
-						std::list<walker*> newlist = myscreen->find_friends_in_range(
-						              myscreen->level_data.oblist, 30000, &howmany, this);
+						std::vector<walker*> newlist;
+						howmany = myscreen->find_friends_in_range(this, 30000, newlist);
 						
 						for(auto e = newlist.begin(); e != newlist.end(); e++)
 						{
@@ -2968,8 +3061,8 @@ short walker::special()
 				case 5:
 				default: // Burst enemies into flame ..
 				{
-					std::list<walker*> newlist = myscreen->find_foes_in_range(myscreen->level_data.oblist,
-					                                      80+2*stats->level, &howmany, this);
+					std::vector<walker*> newlist;
+					howmany = myscreen->find_foes_in_range(this, 80+2*stats->level, newlist);
 					if (!howmany)
 						return 0; // didn't find any enemies..
                     
@@ -2993,7 +3086,7 @@ short walker::special()
 							return 0; // failsafe
                         
 						newob->owner = this;
-						newob->team_num = team_num;
+						newob->set_team(team_num);
 						newob->stats->level = stats->level;
 						newob->damage = generic;
 						newob->center_on(ob);
@@ -3089,8 +3182,8 @@ short walker::special()
 						generic = 80;
                     
                     {
-                        std::list<walker*> newlist = myscreen->find_foes_in_range(myscreen->level_data.oblist,
-					                                      generic+2*stats->level, &howmany, this);
+                        std::vector<walker*> newlist;
+                        howmany = myscreen->find_foes_in_range(this, generic+2*stats->level, newlist);
                         if (!howmany)
                             return 0; // didn't find any enemies..
                         
@@ -3115,7 +3208,7 @@ short walker::special()
                                     return 0; // failsafe
                                 
                                 newob->owner = this;
-                                newob->team_num = team_num;
+                                newob->set_team(team_num);
                                 newob->stats->level = stats->level;
                                 newob->stats->set_bit_flags(BIT_MAGICAL, 1);
                                 newob->damage = generic;
@@ -3140,7 +3233,7 @@ short walker::special()
                             newob->center_on(this);
                             newob->owner = this;
                             newob->stats->level = stats->level;
-                            newob->team_num = team_num;
+                            newob->set_team(team_num);
                             // Use half our remaining magic ..
                             generic = stats->magicpoints - stats->special_cost[2];
                             generic /= 2;
@@ -3199,7 +3292,7 @@ short walker::special()
 									             ypos+((newob->sizey+1)*j));
 									newob->stats->level = (stats->level+1)/2;
 									newob->set_difficulty(newob->stats->level);
-									newob->team_num = team_num; // set to our team
+									newob->set_team(team_num); // set to our team
 									newob->owner = this; // we're owned!
 									newob->lifetime = 200 + 60*stats->level;
 								} // end of successfully put summoned creature
@@ -3346,7 +3439,7 @@ short walker::special()
 									             ypos+((newob->sizey+1)*j));
 									newob->stats->level = (stats->level+2)/3;
 									newob->set_difficulty(newob->stats->level);
-									newob->team_num = team_num; // set to our team
+									newob->set_team(team_num); // set to our team
 									newob->owner = this; // we're owned!
 									newob->lifetime = 100 + 20*stats->level;
 									//newob->stats->armor = -(newob->stats->max_hitpoints*10);
@@ -3371,8 +3464,8 @@ short walker::special()
 						return 0;
 						
                     {
-                        std::list<walker*> newlist = myscreen->find_foes_in_range(myscreen->level_data.oblist,
-                                                              80+4*stats->level, &howmany, this);
+                        std::vector<walker*> newlist;
+                        howmany = myscreen->find_foes_in_range(this, 80+4*stats->level, newlist, true);
                         if (howmany < 1)
                             return 0; // noone to influence
                         
@@ -3392,13 +3485,13 @@ short walker::special()
                                 if (generic < 0 || (!random(20)) ) // trying to control a higher-level
                                 {
                                     ob->real_team_num = ob->team_num;
-                                    ob->team_num = random(8);
+                                    ob->set_team(random(8));
                                     ob->charm_left = 25 + random(generic*20);
                                 }
                                 else
                                 {
                                     ob->real_team_num = ob->team_num;
-                                    ob->team_num = team_num;
+                                    ob->set_team(team_num);
                                     ob->foe = NULL; // allow choice of new foe
                                     ob->charm_left = 25 + random(generic*20);
                                 }
@@ -3489,7 +3582,7 @@ short walker::special()
 			             ypos+sizey/2 - newob->sizey/2);
 			newob->owner = this;
 			newob->stats->level = stats->level;
-			newob->team_num = team_num; // so we scare OTHER teams
+			newob->set_team(team_num); // so we scare OTHER teams
 			// Actual scare effect done in scare's "death" in effect
 			break;
 		case FAMILY_THIEF:
@@ -3531,8 +3624,8 @@ short walker::special()
 							return 0;
 							
                         {
-                            std::list<walker*> newlist = myscreen->find_foes_in_range(myscreen->level_data.oblist,
-                                                                  80+4*stats->level, &howmany, this);
+                            std::vector<walker*> newlist;
+                            howmany = myscreen->find_foes_in_range(this, 80+4*stats->level, newlist);
                             
                             for(auto e = newlist.begin(); e != newlist.end(); e++)
                             {
@@ -3565,8 +3658,8 @@ short walker::special()
 							return 0;
                         
                         {
-                            std::list<walker*> newlist = myscreen->find_foes_in_range(myscreen->level_data.oblist,
-                                                                  16+4*stats->level, &howmany, this);
+                            std::vector<walker*> newlist;
+                            howmany = myscreen->find_foes_in_range(this, 16+4*stats->level, newlist, true);
                             
                             if (howmany < 1)
                                 return 0; // noone to influence
@@ -3591,7 +3684,7 @@ short walker::special()
                                     else
                                     {
                                         ob->real_team_num = ob->team_num;
-                                        ob->team_num = team_num;
+                                        ob->set_team(team_num);
                                         if (foe == ob)
                                             ob->foe = NULL;
                                         else
@@ -3633,7 +3726,7 @@ short walker::special()
 					newob->center_on(this);
 					newob->invisibility_left = 10;
 					newob->ani_type = ANI_SPIN; // non-walking
-					newob->team_num = team_num;
+					newob->set_team(team_num);
 					newob->stats->level = stats->level;
 					newob->damage = stats->level;
 					newob->owner = this;
@@ -3713,7 +3806,7 @@ short walker::special()
 					busy += (fire_frequency * 2);
 					alive = myscreen->level_data.add_ob(ORDER_WEAPON,FAMILY_TREE);
 					alive->setxy(newob->xpos,newob->ypos);
-					alive->team_num = team_num;
+					alive->set_team(team_num);
 					alive->ani_type = ANI_GROW;
 					alive->owner = this;
 					newob->dead = 1;
@@ -3727,7 +3820,7 @@ short walker::special()
 						return 0;
 					alive = myscreen->level_data.add_ob(ORDER_LIVING, FAMILY_FAERIE);
 					alive->setxy(newob->xpos, newob->ypos);
-					alive->team_num = team_num;
+					alive->set_team(team_num);
 					alive->owner = this;
 					alive->lifetime = 50 + stats->level*(40);
 					newob->dead = 1;
@@ -3750,8 +3843,8 @@ short walker::special()
 						return 0;
                     
                     {
-                        std::list<walker*> newlist = myscreen->find_friends_in_range(myscreen->level_data.oblist,
-                                  60, &howmany, this);
+                        std::vector<walker*> newlist;
+                        howmany = myscreen->find_friends_in_range(this, 60, newlist);
                         didheal = 0;
                         if (howmany > 1) // some friends here ..
                         {
@@ -3783,7 +3876,7 @@ short walker::special()
                                         
                                         alive->owner = newob;
                                         alive->center_on(newob);
-                                        alive->team_num = newob->team_num;
+                                        alive->set_team(newob->team_num);
                                         alive->stats->level = newob->stats->level;
                                         didheal++;
                                     } // end of target wasn't protected
@@ -3837,8 +3930,8 @@ short walker::special()
 					busy += 2;
 					
 					{
-                        std::list<walker*> newlist = myscreen->find_foes_in_range(myscreen->level_data.oblist,
-					                                      160+(20*stats->level), &howmany, this);
+                        std::vector<walker*> newlist;
+                        howmany = myscreen->find_foes_in_range(this, 160+(20*stats->level), newlist);
                         
                         for(auto e = newlist.begin(); e != newlist.end(); e++)
                         {
@@ -4052,8 +4145,8 @@ Sint32 walker::turn_undead(Sint32 range, Sint32 power)
 	Sint32 killed = 0;
 	short targets;
 
-	std::list<walker*> deadlist = myscreen->find_foes_in_range(myscreen->level_data.oblist, range,
-	                                       &targets, this);
+	std::vector<walker*> deadlist;
+	targets = myscreen->find_foes_in_range(this, range, deadlist);
 	if (!targets)
 		return -1;
 
@@ -4424,6 +4517,7 @@ void walker::transfer_stats(walker  *newob)
 		
 		newob->myguy = newguy;
 	}
+	newob->recount();
 }
 
 // change picture, etc. but NOT stats (use transfer_stats for that)
@@ -4457,6 +4551,8 @@ void walker::transform_to(char whatorder, char whatfamily)
 	data = myscreen->level_data.myloader->graphics[PIX(order, family)];
 	facings = data.data;
 	bmp = data.data;
+	spans = data.spans;
+	bmp_spans = data.frame_spans(0);
 	frames = data.frames;
 	frame = 0;
 	cycle = 0;
@@ -4482,6 +4578,7 @@ void walker::transform_to(char whatorder, char whatfamily)
 	// of protection, etc., which are special cases .. instead:
 	set_frame(0);
 	animate();
+	recount();  // we may not be a living any more, or be one now
 }
 
 
@@ -4499,13 +4596,14 @@ short walker::death()
 		return 0;
 
 	death_called = 1;
+	recount();
 
 	if (myguy) // were we a real character?  Then make a heart ..
 	{
 		newob = myscreen->level_data.add_ob(ORDER_TREASURE, FAMILY_LIFE_GEM, 1);
 		newob->stats->hitpoints = myguy->query_heart_value();
 		newob->stats->hitpoints *= 0.75 / 2;  // 75%, divided by 2, since score is doubled at end of level
-		newob->team_num = team_num;
+		newob->set_team(team_num);
 		newob->center_on(this);
 	}
 
@@ -4529,7 +4627,7 @@ short walker::death()
 					dead = 1;
 					//transform_to(ORDER_LIVING, FAMILY_MEDIUM_SLIME);
 					newob = myscreen->level_data.add_ob(ORDER_LIVING, FAMILY_MEDIUM_SLIME);
-					newob->team_num = team_num;
+					newob->set_team(team_num);
 					newob->stats->level = stats->level;
 					newob->set_difficulty(stats->level);
 					newob->foe = foe;
@@ -4540,6 +4638,7 @@ short walker::death()
 					{
 						newob->myguy = myguy;
 						myguy = NULL;
+						newob->recount();
 					}
 					newob->center_on(this);
 					stats->hitpoints = stats->max_hitpoints;
@@ -4548,7 +4647,7 @@ short walker::death()
 					dead = 1;
 					//transform_to(ORDER_LIVING, FAMILY_SMALL_SLIME);
 					newob = myscreen->level_data.add_ob(ORDER_LIVING, FAMILY_SMALL_SLIME);
-					newob->team_num = team_num;
+					newob->set_team(team_num);
 					newob->stats->level = stats->level;
 					newob->set_difficulty(stats->level);
 					newob->foe = foe;
@@ -4559,6 +4658,7 @@ short walker::death()
 					{
 						newob->myguy = myguy;
 						myguy = NULL;
+						newob->recount();
 					}
 					newob->center_on(this);
 					stats->hitpoints = stats->max_hitpoints;
@@ -4578,7 +4678,7 @@ short walker::death()
 				newob = myscreen->level_data.add_ob(ORDER_FX, FAMILY_EXPLOSION, 1);
 				if (!newob) // failsafe
 					break;
-				newob->team_num = team_num;
+				newob->set_team(team_num);
 				newob->stats->level = stats->level;
 				newob->ani_type = ANI_EXPLODE;
 				newob->setxy(xpos+random(sizex-8)+4, ypos+4+random(sizey-8) );
@@ -4617,7 +4717,7 @@ void walker::generate_bloodspot()
 	bloodstain->stats->old_order = order;
 	bloodstain->stats->old_family= family;
 
-	bloodstain->team_num = team_num;
+	bloodstain->set_team(team_num);
 	bloodstain->dead = 0;
 	bloodstain->setxy(xpos, ypos);
 	//data = myscreen->myloader->graphics[PIX(ORDER_TREASURE, FAMILY_STAIN)];
@@ -4644,6 +4744,7 @@ void walker::set_direct_frame(short whichframe)
 
 	data = myscreen->level_data.myloader->graphics[PIX(order, family)];
 	bmp = data.data + frame*size;
+	bmp_spans = data.frame_spans(frame);
 
 }
 
@@ -4804,6 +4905,20 @@ Sint32 walker::is_friendly(walker *target)
 	return 1;
 }
 
+void walker::set_team(unsigned char team)
+{
+	team_num = team;
+	recount();
+	if (mylevel)
+		mylevel->late_foe(this);
+}
+
+void walker::recount()
+{
+	if (mylevel)
+		mylevel->count_living(this);
+}
+
 Sint32 walker::is_friendly_to_team(unsigned char team)
 {
 	// is_friendly_to_team determines if _team_ is "friendly"
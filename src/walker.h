@@ -23,6 +23,8 @@
 #include "pixien.h"
 #include "obmap.h"
 
+class LevelData;
+
 class walker : public pixieN
 {
 	public:
@@ -39,6 +41,9 @@ class walker : public pixieN
 		bool walkstep(float x, float y);
 		virtual bool walk(float x, float y);
 		short draw(viewscreen  *view_buf);
+		void prepare_frame(short views);
+		void prepare_draw(viewscreen  *view_buf);
+		short draw_prepared(viewscreen  *view_buf);
 		short draw_tile(viewscreen  *view_buf);
 		void draw_path(viewscreen* view_buf);
 		void find_path_to_foe();
@@ -91,6 +96,8 @@ class walker : public pixieN
 		unsigned char query_team_color();
 		Sint32 is_friendly(walker *target);
 		Sint32 is_friendly_to_team(unsigned char team);
+		void set_team(unsigned char team);  // use this, so the level's counts follow
+		void recount();  // after a change to dead, order or myguy
 		inline short query_type(char oval, char fval)
 		{
 			if (oval == order && fval == family)
@@ -144,12 +151,23 @@ class walker : public pixieN
 		Sint32 lifetime; // how much life summoned guys have ..
 		short skip_exit; // cycles after failed exit choice
 		unsigned char outline;
+		unsigned char view_outline[MAX_VIEWS]; // outline and hurt flash each
+		bool view_flash[MAX_VIEWS];            // viewscreen got from prepare_draw()
+		bool frame_flash;                      // hurt flash not yet drawn this frame
+		char draw_layer;                       // 0 effects, 1 objects, 2 weapons
+		Uint32 draw_order;                     // when we were added to our list
 		short speed_bonus;             // These two are used for
 		short speed_bonus_left;        // speed potions, etc.
 		short regen_delay;  // Delay after being hit
 		// Zardus: ADD: in_act should be set while in an action
 		bool in_act;
 		obmap* myobmap;
+		short obmap_x0, obmap_y0, obmap_x1, obmap_y1;  // our block of obmap cells
+		char obmap_layer;                              // which cells those are, OBMAP_NONE if none
+		LevelData* mylevel;                            // whose oblist we're in, if any
+		char counted;                                  // in mylevel->living_count, under
+		unsigned char counted_team;                    // this team
+		char counted_hired;                            // and this hire
 		int path_check_counter;
 		std::vector<void*> path_to_foe;  // Result from pathfinding
 		
@@ -222,7 +222,7 @@ short weap::death()
 			newob->ani_type = ANI_DOOR_OPEN;
 			newob->setxy(xpos, ypos);
 			newob->stats->level = stats->level;
-			newob->team_num = team_num;
+			newob->set_team(team_num);
 			//      newob->ignore = 1;
 			// What way are we 'facing'?
 			if (myscreen->level_data.mysmoother.query_genre_x_y((xpos/GRID_SIZE),(ypos/GRID_SIZE)-1)